@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include "small_vector.h"
+
+namespace signals::combiners {
+/*
+Комбинатор получает пару input-итераторов по результатам слотов
+и сворачивает их в результат эмиссии. Слот вызывается, только когда
+комбинатор разыменовывает итератор, поэтому комбинатор, который
+остановился раньше, не вызывает оставшиеся слоты.
+*/
+
+/* Результат последнего слота или T{}, если слотов нет. */
+template<typename T>
+struct last {
+  template<typename InputIt>
+  T operator()(InputIt first, InputIt end) const {
+    T result{};
+    for (; first != end; ++first) {
+      result = *first;
+    }
+    return result;
+  }
+};
+
+/* Результат первого слота. Остальные слоты не вызываются. */
+template<typename T>
+struct optional_first {
+  template<typename InputIt>
+  std::optional<T> operator()(InputIt first, InputIt end) const {
+    if (first == end) {
+      return std::nullopt;
+    }
+    return *first;
+  }
+};
+
+template<typename T>
+struct sum {
+  template<typename InputIt>
+  T operator()(InputIt first, InputIt end) const {
+    T result{};
+    for (; first != end; ++first) {
+      result += *first;
+    }
+    return result;
+  }
+};
+
+/* Наибольший результат или nullopt, если слотов нет. */
+template<typename T>
+struct max {
+  template<typename InputIt>
+  std::optional<T> operator()(InputIt first, InputIt end) const {
+    std::optional<T> result;
+    for (; first != end; ++first) {
+      if (!result || *result < *first) {
+        result = *first;
+      }
+    }
+    return result;
+  }
+};
+
+/* Результаты всех слотов в порядке вызова. */
+template<typename T, std::size_t N = 8>
+struct collect {
+  template<typename InputIt>
+  small_vector<T, N> operator()(InputIt first, InputIt end) const {
+    small_vector<T, N> result;
+    for (; first != end; ++first) {
+      result.push_back(*first);
+    }
+    return result;
+  }
+};
+
+/*
+Первый результат, для которого pred вернул true. Слоты после него
+не вызываются. Если такого результата нет, nullopt.
+*/
+template<typename T, typename Pred>
+struct short_circuit {
+  explicit short_circuit(Pred pred = Pred()) : pred(std::move(pred)) {}
+
+  template<typename InputIt>
+  std::optional<T> operator()(InputIt first, InputIt end) const {
+    for (; first != end; ++first) {
+      if (pred(*first)) {
+        return *first;
+      }
+    }
+    return std::nullopt;
+  }
+
+ private:
+  Pred pred;
+};
+}
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "signal_options.h"
+#include "small_function.h"
+
+namespace signals {
+
+template<typename T, typename... Options>
+struct concurrent_signal;
+
+/*
+Потокобезопасный вариант signal. Эмиссия не берёт блокировок:
+она работает с неизменяемым снимком списка слотов, который
+защищён от удаления счётчиками читателей двух эпох (как в SRCU).
+connect и disconnect сериализуются мьютексом, публикуют новый
+снимок и дожидаются выхода читателей, которые могли видеть старый.
+
+После того как disconnect вернул управление, слот не выполняется
+ни в одном потоке и больше не будет вызван. Если disconnect вызван
+из эмиссии этого же сигнала в этом же потоке, то ожидание невозможно:
+текущие вызовы слота в других потоках могут завершиться,
+но новых вызовов не будет, а разрушение слота откладывается.
+
+Разрушение сигнала не должно пересекаться ни с какими
+операциями над ним в других потоках.
+*/
+template<typename... Args, typename... Options>
+struct concurrent_signal<void(Args...), Options...> {
+  using slot_t = small_function<void(Args...),
+                                detail::find_option_t<slot_buffer_option, default_slot_buffer, Options...>::size>;
+
+  /* Слоты могут вызываться из нескольких эмиссий одновременно (см. connect_queued). */
+  static constexpr bool concurrent_emission = true;
+
+ private:
+  struct slot_node;
+
+ public:
+  struct connection {
+    connection() = default;
+
+    connection(connection &&other) noexcept
+        : sig(std::exchange(other.sig, nullptr)), node(std::exchange(other.node, nullptr)) {
+      if (node != nullptr) {
+        node->owner = this;
+      }
+    }
+
+    connection &operator=(connection &&other) noexcept {
+      if (this == &other) {
+        return *this;
+      }
+
+      disconnect();
+      sig = std::exchange(other.sig, nullptr);
+      node = std::exchange(other.node, nullptr);
+      if (node != nullptr) {
+        node->owner = this;
+      }
+
+      return *this;
+    }
+
+    void disconnect() noexcept {
+      if (sig != nullptr) {
+        sig->disconnect(node);
+        sig = nullptr;
+        node = nullptr;
+      }
+    }
+
+    ~connection() {
+      disconnect();
+    }
+
+   private:
+    connection(concurrent_signal *sig, slot_node *node) noexcept : sig(sig), node(node) {
+      node->owner = this;
+    }
+
+    friend concurrent_signal;
+
+    concurrent_signal *sig = nullptr;
+    slot_node *node = nullptr;
+  };
+
+  concurrent_signal() : current(new snapshot) {}
+
+  concurrent_signal(concurrent_signal const &) = delete;
+  concurrent_signal &operator=(concurrent_signal const &) = delete;
+
+  ~concurrent_signal() {
+    snapshot *last = current.load(std::memory_order_relaxed);
+    for (slot_node *node : last->slots) {
+      node->owner->sig = nullptr;
+      node->owner->node = nullptr;
+      delete node;
+    }
+    delete last;
+    reclaim(retired.size());
+  }
+
+  connection connect(slot_t slot) {
+    slot_node *node = new slot_node(std::move(slot));
+    {
+      std::lock_guard<std::mutex> lg(writer_mutex);
+      snapshot *old = current.load(std::memory_order_relaxed);
+      snapshot *fresh = new snapshot;
+      fresh->slots.reserve(old->slots.size() + 1);
+      fresh->slots.push_back(node);
+      fresh->slots.insert(fresh->slots.end(), old->slots.begin(), old->slots.end());
+      current.store(fresh);
+      retire(old, nullptr);
+    }
+    synchronize();
+    return connection(this, node);
+  }
+
+  /* Аргументы передаются слотам по ссылке, rvalue-аргументы - как const lvalue. */
+  void operator()(detail::call_arg_t<Args>... args) const {
+    reader_guard guard(*this);
+
+    snapshot const *snap = current.load();
+    for (slot_node *node : snap->slots) {
+      if (node->connected.load(std::memory_order_acquire)) {
+        node->slot.call_shared(std::forward<detail::call_arg_t<Args>>(args)...);
+      }
+    }
+  }
+
+ private:
+  struct slot_node {
+    explicit slot_node(slot_t slot) noexcept : slot(std::move(slot)) {}
+
+    slot_t slot;
+    std::atomic<bool> connected{true};
+    connection *owner = nullptr;
+  };
+
+  struct snapshot {
+    std::vector<slot_node *> slots;
+  };
+
+  /* Снимок или слот, отложенные до окончания периода ожидания. */
+  struct retired_entry {
+    snapshot *snap;
+    slot_node *node;
+    std::uint64_t epoch;
+  };
+
+  struct reader_guard {
+    explicit reader_guard(concurrent_signal const &sig) noexcept : sig(sig), next(top_guard) {
+      for (;;) {
+        epoch = sig.epoch.load();
+        sig.readers[epoch & 1].count.fetch_add(1);
+        if (sig.epoch.load() == epoch) {
+          break;
+        }
+        sig.readers[epoch & 1].count.fetch_sub(1);
+      }
+      top_guard = this;
+    }
+
+    ~reader_guard() {
+      top_guard = next;
+      sig.readers[epoch & 1].count.fetch_sub(1, std::memory_order_release);
+    }
+
+    concurrent_signal const &sig;
+    reader_guard *next;
+    std::uint64_t epoch;
+  };
+
+  struct alignas(64) reader_counter {
+    std::atomic<std::uint64_t> count{0};
+  };
+
+  void disconnect(slot_node *node) noexcept {
+    {
+      std::lock_guard<std::mutex> lg(writer_mutex);
+      node->connected.store(false, std::memory_order_release);
+      snapshot *old = current.load(std::memory_order_relaxed);
+      snapshot *fresh = new snapshot;
+      fresh->slots.reserve(old->slots.size());
+      for (slot_node *n : old->slots) {
+        if (n != node) {
+          fresh->slots.push_back(n);
+        }
+      }
+      current.store(fresh);
+      retire(old, node);
+    }
+    synchronize();
+  }
+
+  void retire(snapshot *snap, slot_node *node) {
+    retired.push_back({snap, node, epoch.load()});
+  }
+
+  bool emitting_on_this_thread() const noexcept {
+    for (reader_guard *guard = top_guard; guard != nullptr; guard = guard->next) {
+      if (&guard->sig == this) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /*
+  Переключает эпоху и ждёт, пока выйдут все читатели, вошедшие
+  до переключения. После этого можно освободить всё, что было
+  отложено не позже этой эпохи. Изнутри собственной эмиссии
+  ждать нельзя, поэтому освобождение откладывается до следующего
+  вызова или до разрушения сигнала.
+  */
+  void synchronize() noexcept {
+    if (emitting_on_this_thread()) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> sync_lg(sync_mutex);
+    std::uint64_t flipped = epoch.fetch_add(1);
+    while (readers[flipped & 1].count.load(std::memory_order_acquire) != 0) {
+      std::this_thread::yield();
+    }
+
+    std::lock_guard<std::mutex> lg(writer_mutex);
+    std::size_t safe = 0;
+    while (safe < retired.size() && retired[safe].epoch <= flipped) {
+      ++safe;
+    }
+    reclaim(safe);
+  }
+
+  void reclaim(std::size_t count) noexcept {
+    for (std::size_t i = 0; i < count; ++i) {
+      delete retired[i].snap;
+      delete retired[i].node;
+    }
+    retired.erase(retired.begin(), retired.begin() + count);
+  }
+
+  std::atomic<snapshot *> current;
+  mutable std::atomic<std::uint64_t> epoch{0};
+  mutable reader_counter readers[2];
+
+  std::mutex writer_mutex;
+  std::mutex sync_mutex;
+  std::vector<retired_entry> retired;
+
+  static inline thread_local reader_guard *top_guard = nullptr;
+};
+}
@@ -0,0 +1,379 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "concurrent_signal.h"
+#include "executor.h"
+#include "queued_connection.h"
+#include "signals.h"
+
+TEST(concurrent_signal_testing, trivial)
+{
+    signals::concurrent_signal<void(int)> sig;
+    int got1 = 0;
+    auto conn1 = sig.connect([&](int x) { got1 += x; });
+    int got2 = 0;
+    auto conn2 = sig.connect([&](int x) { got2 += x; });
+
+    sig(3);
+
+    EXPECT_EQ(3, got1);
+    EXPECT_EQ(3, got2);
+
+    conn1.disconnect();
+    sig(4);
+
+    EXPECT_EQ(3, got1);
+    EXPECT_EQ(7, got2);
+}
+
+TEST(concurrent_signal_testing, disconnect_in_emit)
+{
+    using connection = signals::concurrent_signal<void()>::connection;
+    signals::concurrent_signal<void()> sig;
+    uint32_t got1 = 0;
+    auto conn1 = std::make_unique<connection>(sig.connect([&] { ++got1; }));
+    uint32_t got2 = 0;
+    std::unique_ptr<connection> conn2;
+    conn2.reset(new connection(sig.connect([&] { ++got2; conn1.reset(); conn2.reset(); })));
+    uint32_t got3 = 0;
+    auto conn3 = std::make_unique<connection>(sig.connect([&] { ++got3; }));
+
+    sig();
+
+    EXPECT_EQ(0u, got1);
+    EXPECT_EQ(1u, got2);
+    EXPECT_EQ(1u, got3);
+
+    sig();
+
+    EXPECT_EQ(0u, got1);
+    EXPECT_EQ(1u, got2);
+    EXPECT_EQ(2u, got3);
+}
+
+TEST(concurrent_signal_testing, connect_in_emit)
+{
+    using connection = signals::concurrent_signal<void()>::connection;
+    signals::concurrent_signal<void()> sig;
+    uint32_t got_inner = 0;
+    connection inner;
+    auto outer = sig.connect([&] { inner = sig.connect([&] { ++got_inner; }); });
+
+    sig();
+    EXPECT_EQ(0u, got_inner);
+
+    sig();
+    EXPECT_EQ(1u, got_inner);
+}
+
+TEST(concurrent_signal_testing, destroy_signal_before_connection)
+{
+    auto sig = std::make_unique<signals::concurrent_signal<void()>>();
+    auto conn1_old = sig->connect([] {});
+
+    sig.reset();
+
+    auto conn1_new = std::move(conn1_old);
+    conn1_new.disconnect();
+}
+
+TEST(concurrent_signal_testing, concurrent_emit)
+{
+    signals::concurrent_signal<void()> sig;
+    std::atomic<uint64_t> got{0};
+    auto conn = sig.connect([&] { got.fetch_add(1, std::memory_order_relaxed); });
+
+    std::vector<std::thread> emitters;
+    for (int i = 0; i < 4; ++i)
+    {
+        emitters.emplace_back([&]
+        {
+            for (int j = 0; j < 10000; ++j)
+                sig();
+        });
+    }
+    for (auto& t : emitters)
+        t.join();
+
+    EXPECT_EQ(40000u, got.load());
+}
+
+TEST(concurrent_signal_testing, no_call_after_disconnect)
+{
+    using connection = signals::concurrent_signal<void()>::connection;
+    signals::concurrent_signal<void()> sig;
+    std::atomic<bool> stop{false};
+    std::atomic<uint32_t> violations{0};
+
+    std::vector<std::thread> emitters;
+    for (int i = 0; i < 3; ++i)
+    {
+        emitters.emplace_back([&]
+        {
+            while (!stop.load())
+                sig();
+        });
+    }
+
+    std::vector<std::thread> subscribers;
+    for (int i = 0; i < 3; ++i)
+    {
+        subscribers.emplace_back([&]
+        {
+            for (int j = 0; j < 100; ++j)
+            {
+                auto disconnected = std::make_shared<std::atomic<bool>>(false);
+                connection conn = sig.connect([&violations, disconnected]
+                {
+                    if (disconnected->load())
+                        violations.fetch_add(1);
+                });
+                std::this_thread::yield();
+                conn.disconnect();
+                disconnected->store(true);
+            }
+        });
+    }
+
+    for (auto& t : subscribers)
+        t.join();
+    stop.store(true);
+    for (auto& t : emitters)
+        t.join();
+
+    EXPECT_EQ(0u, violations.load());
+}
+
+TEST(concurrent_signal_testing, slot_destroyed_after_disconnect)
+{
+    signals::concurrent_signal<void()> sig;
+    std::atomic<bool> stop{false};
+
+    std::thread emitter([&]
+    {
+        while (!stop.load())
+            sig();
+    });
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        auto payload = std::make_shared<int>(i);
+        std::weak_ptr<int> weak = payload;
+        auto conn = sig.connect([payload = std::move(payload)] { EXPECT_GE(*payload, 0); });
+        conn.disconnect();
+        EXPECT_TRUE(weak.expired());
+    }
+
+    stop.store(true);
+    emitter.join();
+}
+
+TEST(concurrent_signal_testing, recursive_emit_under_churn)
+{
+    using connection = signals::concurrent_signal<void(int)>::connection;
+    signals::concurrent_signal<void(int)> sig;
+    std::atomic<uint64_t> calls{0};
+    auto conn = sig.connect([&](int depth)
+    {
+        calls.fetch_add(1, std::memory_order_relaxed);
+        if (depth > 0)
+            sig(depth - 1);
+    });
+
+    std::atomic<bool> stop{false};
+    std::thread churn([&]
+    {
+        while (!stop.load())
+        {
+            connection tmp = sig.connect([](int) {});
+            tmp.disconnect();
+        }
+    });
+
+    std::vector<std::thread> emitters;
+    for (int i = 0; i < 2; ++i)
+    {
+        emitters.emplace_back([&]
+        {
+            for (int j = 0; j < 2000; ++j)
+                sig(4);
+        });
+    }
+    for (auto& t : emitters)
+        t.join();
+    stop.store(true);
+    churn.join();
+
+    EXPECT_EQ(2u * 2000 * 5, calls.load());
+}
+
+TEST(concurrent_signal_testing, disconnect_other_in_emit_under_churn)
+{
+    using connection = signals::concurrent_signal<void()>::connection;
+    signals::concurrent_signal<void()> sig;
+    std::atomic<bool> stop{false};
+
+    std::vector<std::thread> emitters;
+    for (int i = 0; i < 2; ++i)
+    {
+        emitters.emplace_back([&]
+        {
+            while (!stop.load())
+                sig();
+        });
+    }
+
+    for (int i = 0; i < 100; ++i)
+    {
+        auto victim = std::make_unique<connection>(sig.connect([] {}));
+        std::atomic<bool> fired{false};
+        std::atomic<bool> done{false};
+        connection killer = sig.connect([&]
+        {
+            if (!fired.exchange(true))
+            {
+                victim.reset();
+                done.store(true);
+            }
+        });
+        while (!done.load())
+            std::this_thread::yield();
+    }
+
+    stop.store(true);
+    for (auto& t : emitters)
+        t.join();
+}
+
+TEST(queued_connection_testing, event_loop_delivery)
+{
+    signals::signal<void(std::string const&, int)> sig;
+    signals::event_loop loop;
+    std::vector<std::string> got;
+    auto conn = signals::connect_queued(sig, loop, [&](std::string const& s, int x)
+    {
+        got.push_back(s + std::to_string(x));
+    });
+
+    {
+        std::string temporary = "a";
+        sig(temporary, 1);
+        temporary = "b";
+        sig(temporary, 2);
+    }
+    EXPECT_TRUE(got.empty());
+
+    EXPECT_EQ(2u, loop.poll());
+    EXPECT_EQ((std::vector<std::string>{"a1", "b2"}), got);
+}
+
+TEST(queued_connection_testing, disconnect_before_delivery)
+{
+    signals::signal<void(int)> sig;
+    signals::event_loop loop;
+    auto payload = std::make_shared<int>(0);
+    std::weak_ptr<int> weak = payload;
+    uint32_t got = 0;
+    auto conn = signals::connect_queued(sig, loop, [&got, payload = std::move(payload)](int) { ++got; });
+
+    sig(1);
+    sig(2);
+    conn.disconnect();
+    EXPECT_FALSE(weak.expired());
+
+    EXPECT_EQ(2u, loop.poll());
+    EXPECT_EQ(0u, got);
+    EXPECT_TRUE(weak.expired());
+}
+
+TEST(queued_connection_testing, event_loop_destroyed_with_pending_messages)
+{
+    signals::signal<void(int)> sig;
+    auto payload = std::make_shared<int>(0);
+    std::weak_ptr<int> weak = payload;
+    uint32_t got = 0;
+    {
+        signals::event_loop loop;
+        auto conn = signals::connect_queued(sig, loop, [&got, payload = std::move(payload)](int) { ++got; });
+        sig(1);
+    }
+    EXPECT_EQ(0u, got);
+    EXPECT_TRUE(weak.expired());
+}
+
+TEST(queued_connection_testing, event_loop_on_other_thread)
+{
+    signals::signal<void(int)> sig;
+    signals::event_loop loop;
+    std::thread::id emitter = std::this_thread::get_id();
+    std::atomic<uint32_t> sum{0};
+    std::atomic<uint32_t> foreign{0};
+    auto conn = signals::connect_queued(sig, loop, [&](int x)
+    {
+        if (std::this_thread::get_id() != emitter)
+            foreign.fetch_add(1);
+        sum.fetch_add(x);
+    });
+
+    std::thread consumer([&] { loop.run(); });
+    for (int i = 1; i <= 100; ++i)
+        sig(i);
+    loop.stop();
+    consumer.join();
+
+    EXPECT_EQ(5050u, sum.load());
+    EXPECT_EQ(100u, foreign.load());
+}
+
+TEST(queued_connection_testing, thread_pool_delivery)
+{
+    signals::signal<void(std::string)> sig;
+    std::atomic<std::size_t> total{0};
+    std::atomic<uint32_t> direct{0};
+    auto plain = sig.connect([&](std::string const&) { direct.fetch_add(1); });
+    signals::signal<void(std::string)>::connection conn;
+    {
+        signals::thread_pool pool(2);
+        conn = signals::connect_queued(sig, pool, [&](std::string s) { total.fetch_add(s.size()); });
+
+        for (int i = 0; i < 1000; ++i)
+            sig(std::string(10, 'x'));
+    }
+
+    EXPECT_EQ(10000u, total.load());
+    EXPECT_EQ(1000u, direct.load());
+}
+
+TEST(queued_connection_testing, concurrent_signal_many_emitters)
+{
+    signals::concurrent_signal<void(int)> sig;
+    std::atomic<uint64_t> sum{0};
+    signals::concurrent_signal<void(int)>::connection conn;
+    {
+        signals::thread_pool pool(2);
+        conn = signals::connect_queued(sig, pool, [&](int x) { sum.fetch_add(x); });
+
+        std::vector<std::thread> emitters;
+        for (int t = 0; t < 4; ++t)
+        {
+            emitters.emplace_back([&]
+            {
+                for (int i = 1; i <= 10000; ++i)
+                    sig(i);
+            });
+        }
+        for (auto& t : emitters)
+            t.join();
+    }
+
+    EXPECT_EQ(4 * 50005000ull, sum.load());
+}
+
+int main(int argc, char** argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
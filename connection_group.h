@@ -0,0 +1,188 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace signals {
+/*
+Владеет подключениями к любым сигналам и разрывает их все разом:
+при disconnect_all или в деструкторе. Подключения размещаются подряд
+в собственных блоках памяти группы (арене), поэтому добавление не
+аллоцирует, пока есть место в уже выделенном блоке. Подключения одного
+типа, добавленные подряд, образуют серию, которую disconnect_all
+разрушает одним циклом без косвенных вызовов. Память блоков при этом
+не освобождается, а переиспользуется следующими add.
+*/
+struct connection_group {
+  connection_group() noexcept = default;
+
+  connection_group(connection_group const &) = delete;
+  connection_group &operator=(connection_group const &) = delete;
+
+  connection_group(connection_group &&other) noexcept
+      : first_chunk(std::exchange(other.first_chunk, nullptr)),
+        current(std::exchange(other.current, nullptr)),
+        first_run(std::exchange(other.first_run, nullptr)),
+        last_run(std::exchange(other.last_run, nullptr)),
+        count(std::exchange(other.count, 0)) {}
+
+  connection_group &operator=(connection_group &&other) noexcept {
+    if (this != &other) {
+      connection_group tmp(std::move(other));
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  ~connection_group() {
+    disconnect_all();
+    while (first_chunk != nullptr) {
+      chunk *next = first_chunk->next;
+      ::operator delete(first_chunk);
+      first_chunk = next;
+    }
+  }
+
+  /* Забирает подключение во владение группы. */
+  template<typename Connection>
+  void add(Connection &&conn) {
+    static_assert(!std::is_lvalue_reference_v<Connection>, "connection must be moved into the group");
+    static_assert(alignof(Connection) <= alignof(std::max_align_t), "over-aligned connections are not supported");
+
+    if (last_run != nullptr && last_run->destroy == &destroy_run<Connection>
+        && tail() == reinterpret_cast<unsigned char *>(elements<Connection>(last_run) + last_run->count)
+        && current->used + sizeof(Connection) <= current->size) {
+      new(tail()) Connection(std::move(conn));
+      current->used += sizeof(Connection);
+    } else {
+      constexpr std::size_t offset = round_up(sizeof(run), alignof(Connection));
+      run *r = new(reserve(offset + sizeof(Connection))) run{nullptr, &destroy_run<Connection>, 0};
+      new(elements<Connection>(r)) Connection(std::move(conn));
+      if (last_run == nullptr) {
+        first_run = r;
+      } else {
+        last_run->next = r;
+      }
+      last_run = r;
+    }
+    ++last_run->count;
+    ++count;
+  }
+
+  template<typename Connection>
+  connection_group &operator+=(Connection &&conn) {
+    add(std::forward<Connection>(conn));
+    return *this;
+  }
+
+  /* Разрывает все подключения в порядке добавления. */
+  void disconnect_all() noexcept {
+    for (run *r = first_run; r != nullptr;) {
+      run *next = r->next;
+      r->destroy(r);
+      r = next;
+    }
+    first_run = nullptr;
+    last_run = nullptr;
+    count = 0;
+    for (chunk *c = first_chunk; c != nullptr; c = c->next) {
+      c->used = round_up(sizeof(chunk), alignof(std::max_align_t));
+    }
+    current = first_chunk;
+  }
+
+  std::size_t size() const noexcept {
+    return count;
+  }
+
+  bool empty() const noexcept {
+    return count == 0;
+  }
+
+  void swap(connection_group &other) noexcept {
+    std::swap(first_chunk, other.first_chunk);
+    std::swap(current, other.current);
+    std::swap(first_run, other.first_run);
+    std::swap(last_run, other.last_run);
+    std::swap(count, other.count);
+  }
+
+ private:
+  static constexpr std::size_t chunk_size = 4096;
+
+  struct chunk {
+    chunk *next;
+    std::size_t size;
+    std::size_t used;
+  };
+
+  /* Заголовок серии в арене, за ним подряд лежат count подключений. */
+  struct run {
+    run *next;
+    void (*destroy)(run *) noexcept;
+    std::size_t count;
+  };
+
+  static constexpr std::size_t round_up(std::size_t n, std::size_t align) noexcept {
+    return (n + align - 1) / align * align;
+  }
+
+  template<typename Connection>
+  static Connection *elements(run *r) noexcept {
+    constexpr std::size_t offset = round_up(sizeof(run), alignof(Connection));
+    return reinterpret_cast<Connection *>(reinterpret_cast<unsigned char *>(r) + offset);
+  }
+
+  template<typename Connection>
+  static void destroy_run(run *r) noexcept {
+    Connection *conns = elements<Connection>(r);
+    for (std::size_t i = 0; i < r->count; ++i) {
+      conns[i].~Connection();
+    }
+  }
+
+  unsigned char *tail() const noexcept {
+    return reinterpret_cast<unsigned char *>(current) + current->used;
+  }
+
+  /* Место под size байт, выровненное по max_align_t. */
+  void *reserve(std::size_t size) {
+    constexpr std::size_t align = alignof(std::max_align_t);
+    constexpr std::size_t header = round_up(sizeof(chunk), align);
+
+    while (current != nullptr && round_up(current->used, align) + size > current->size) {
+      current = current->next;
+    }
+    if (current == nullptr) {
+      /* Каждый следующий блок вдвое больше предыдущего. */
+      chunk *last = first_chunk;
+      while (last != nullptr && last->next != nullptr) {
+        last = last->next;
+      }
+      std::size_t const bytes = std::max(last == nullptr ? chunk_size : last->size * 2, header + size);
+      chunk *fresh = new(::operator new(bytes)) chunk{nullptr, bytes, header};
+      if (last == nullptr) {
+        first_chunk = fresh;
+      } else {
+        last->next = fresh;
+      }
+      current = fresh;
+    }
+
+    std::size_t const place = round_up(current->used, align);
+    current->used = place + size;
+    return reinterpret_cast<unsigned char *>(current) + place;
+  }
+
+  chunk *first_chunk = nullptr;
+  chunk *current = nullptr;
+  run *first_run = nullptr;
+  run *last_run = nullptr;
+  std::size_t count = 0;
+};
+
+using scoped_connections = connection_group;
+}
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "signal_options.h"
+#include "small_function.h"
+
+namespace signals {
+
+template<typename T, typename... Options>
+struct contiguous_signal;
+
+/*
+Вариант signal для сигналов, которые эмитятся часто, а переподключаются
+редко. Слоты хранятся в непрерывном массиве внутри сигнала, а connection
+хранит лишь индекс в нём, поэтому эмиссия - линейный проход по массиву.
+
+Слоты вызываются в порядке подключения. Слоты, подключённые во время
+эмиссии, в ней не вызываются. disconnect работает за O(1): слот
+помечается пустым, а массив уплотняется, когда нет активных эмиссий
+и пустых слотов становится больше половины.
+*/
+template<typename... Args, typename... Options>
+struct contiguous_signal<void(Args...), Options...> {
+  using slot_t = small_function<void(Args...),
+                                detail::find_option_t<slot_buffer_option, default_slot_buffer, Options...>::size>;
+
+  struct connection {
+    connection() = default;
+
+    connection(connection &&other) noexcept
+        : sig(std::exchange(other.sig, nullptr)), index(other.index) {
+      if (sig != nullptr) {
+        sig->entry_at(index).owner = this;
+      }
+    }
+
+    connection &operator=(connection &&other) noexcept {
+      if (this == &other) {
+        return *this;
+      }
+
+      disconnect();
+      sig = std::exchange(other.sig, nullptr);
+      index = other.index;
+      if (sig != nullptr) {
+        sig->entry_at(index).owner = this;
+      }
+
+      return *this;
+    }
+
+    void disconnect() noexcept {
+      if (sig != nullptr) {
+        std::exchange(sig, nullptr)->release(index);
+      }
+    }
+
+    ~connection() {
+      disconnect();
+    }
+
+   private:
+    connection(contiguous_signal *sig, std::size_t index) noexcept : sig(sig), index(index) {
+      sig->entry_at(index).owner = this;
+    }
+
+    friend contiguous_signal;
+
+    contiguous_signal *sig = nullptr;
+    std::size_t index = 0;
+  };
+
+  contiguous_signal() noexcept = default;
+
+  contiguous_signal(contiguous_signal const &) = delete;
+  contiguous_signal &operator=(contiguous_signal const &) = delete;
+
+  ~contiguous_signal() {
+    for (emission *e = top_emission; e != nullptr; e = e->next) {
+      e->sig = nullptr;
+    }
+    for (std::vector<entry> *storage : {&entries, &pending}) {
+      for (entry &e : *storage) {
+        if (e.owner != nullptr) {
+          e.owner->sig = nullptr;
+        }
+      }
+    }
+  }
+
+  connection connect(slot_t slot) {
+    if (top_emission != nullptr) {
+      reserve_flush(entries.size() + pending.size() + 1);
+    }
+    std::vector<entry> &storage = top_emission == nullptr ? entries : pending;
+    storage.push_back({std::move(slot), nullptr});
+    std::size_t index = top_emission == nullptr ? entries.size() - 1 : entries.size() + pending.size() - 1;
+    return connection(this, index);
+  }
+
+  /* Аргументы передаются слотам по ссылке, rvalue-аргументы - как const lvalue. */
+  void operator()(detail::call_arg_t<Args>... args) const {
+    emission e(this);
+
+    std::size_t const size = entries.size();
+    for (std::size_t i = 0; i < size; ++i) {
+      entry const &current = entries[i];
+      if (current.owner == nullptr) {
+        continue;
+      }
+
+      current.slot.call_shared(std::forward<detail::call_arg_t<Args>>(args)...);
+
+      if (e.sig == nullptr) {
+        return;
+      }
+    }
+  }
+
+ private:
+  struct entry {
+    slot_t slot;
+    connection *owner;
+  };
+
+  /*
+  Пока есть хотя бы одна эмиссия, массив entries не меняет размер:
+  новые слоты копятся в pending и переносятся в entries, когда
+  завершается самая внешняя эмиссия.
+  */
+  struct emission {
+    explicit emission(contiguous_signal const *sig) noexcept : sig(sig), next(sig->top_emission) {
+      sig->top_emission = this;
+    }
+
+    ~emission() {
+      if (sig != nullptr) {
+        sig->top_emission = next;
+        if (next == nullptr) {
+          const_cast<contiguous_signal *>(sig)->flush();
+        }
+      }
+    }
+
+    contiguous_signal const *sig;
+    emission *next;
+  };
+
+  entry &entry_at(std::size_t index) noexcept {
+    return index < entries.size() ? entries[index] : pending[index - entries.size()];
+  }
+
+  void release(std::size_t index) noexcept {
+    entry &e = entry_at(index);
+    e.owner = nullptr;
+    e.slot.reset();
+    ++released;
+
+    if (top_emission == nullptr && released * 2 > entries.size()) {
+      compact();
+    }
+  }
+
+  /*
+  Память под перенос pending в entries выделяется заранее в connect,
+  поэтому flush, вызываемый из деструктора эмиссии, не аллоцирует.
+  */
+  void reserve_flush(std::size_t needed) {
+    if (entries.capacity() < needed && grown.capacity() < needed) {
+      grown.reserve(std::max(needed, entries.capacity() * 2));
+    }
+  }
+
+  void flush() noexcept {
+    if (!pending.empty()) {
+      if (entries.capacity() < entries.size() + pending.size()) {
+        for (entry &e : entries) {
+          grown.push_back(std::move(e));
+        }
+        entries.swap(grown);
+        grown = std::vector<entry>();
+      }
+      for (entry &e : pending) {
+        entries.push_back(std::move(e));
+      }
+      pending.clear();
+    }
+    if (released * 2 > entries.size()) {
+      compact();
+    }
+  }
+
+  /* Сдвигает живые слоты к началу массива, сохраняя их порядок. */
+  void compact() noexcept {
+    std::size_t alive = 0;
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+      if (entries[i].owner == nullptr) {
+        continue;
+      }
+      if (alive != i) {
+        entries[alive] = std::move(entries[i]);
+      }
+      entries[alive].owner->index = alive;
+      ++alive;
+    }
+    entries.resize(alive);
+    released = 0;
+  }
+
+  std::vector<entry> entries;
+  std::vector<entry> pending;
+  std::vector<entry> grown;
+  std::size_t released = 0;
+  mutable emission *top_emission = nullptr;
+};
+}
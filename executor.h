@@ -0,0 +1,179 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace signals {
+/*
+Единица работы для исполнителя. Память под задачу принадлежит тому,
+кто её отправил: исполнитель только связывает задачи в очередь,
+поэтому post не аллоцирует. complete(t, true) выполняет задачу,
+complete(t, false) отменяет её, когда исполнитель разрушается
+раньше, чем до неё дошла очередь. В обоих случаях после вызова
+исполнитель задачу больше не трогает.
+
+Исполнитель - любой тип с методом post(task &), потокобезопасным
+относительно других вызовов post.
+*/
+struct task {
+  void (*complete)(task *, bool run);
+  task *next = nullptr;
+};
+
+namespace detail {
+/* FIFO-очередь задач, защищённая мьютексом. */
+struct task_queue {
+  void push(task &t) {
+    {
+      std::lock_guard<std::mutex> lg(mutex);
+      t.next = nullptr;
+      if (tail == nullptr) {
+        head = &t;
+      } else {
+        tail->next = &t;
+      }
+      tail = &t;
+    }
+    ready.notify_one();
+  }
+
+  task *try_pop() {
+    std::lock_guard<std::mutex> lg(mutex);
+    return pop_locked();
+  }
+
+  /* Ждёт задачу. Возвращает nullptr, если очередь закрыта и пуста. */
+  task *wait_pop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    ready.wait(lock, [this] { return head != nullptr || closed; });
+    return pop_locked();
+  }
+
+  void close() {
+    {
+      std::lock_guard<std::mutex> lg(mutex);
+      closed = true;
+    }
+    ready.notify_all();
+  }
+
+  /* Отменяет все задачи, оставшиеся в очереди. */
+  void cancel_all() noexcept {
+    while (task *t = try_pop()) {
+      t->complete(t, false);
+    }
+  }
+
+ private:
+  task *pop_locked() noexcept {
+    task *t = head;
+    if (t != nullptr) {
+      head = t->next;
+      if (head == nullptr) {
+        tail = nullptr;
+      }
+    }
+    return t;
+  }
+
+  std::mutex mutex;
+  std::condition_variable ready;
+  task *head = nullptr;
+  task *tail = nullptr;
+  bool closed = false;
+};
+}
+
+/*
+Однопоточный цикл событий: задачи отправляются из любых потоков,
+а выполняются в потоке, который вызывает run, run_one или poll.
+*/
+struct event_loop {
+  event_loop() = default;
+
+  event_loop(event_loop const &) = delete;
+  event_loop &operator=(event_loop const &) = delete;
+
+  ~event_loop() {
+    queue.cancel_all();
+  }
+
+  void post(task &t) {
+    queue.push(t);
+  }
+
+  /* Выполняет одну готовую задачу, если она есть. */
+  bool run_one() {
+    task *t = queue.try_pop();
+    if (t == nullptr) {
+      return false;
+    }
+    t->complete(t, true);
+    return true;
+  }
+
+  /* Выполняет все готовые задачи и возвращает их число. */
+  std::size_t poll() {
+    std::size_t count = 0;
+    while (run_one()) {
+      ++count;
+    }
+    return count;
+  }
+
+  /* Выполняет задачи, пока не будет вызван stop. */
+  void run() {
+    while (task *t = queue.wait_pop()) {
+      t->complete(t, true);
+    }
+  }
+
+  void stop() {
+    queue.close();
+  }
+
+ private:
+  detail::task_queue queue;
+};
+
+/*
+Пул потоков с общей очередью. Деструктор дожидается выполнения
+всех уже отправленных задач.
+*/
+struct thread_pool {
+  explicit thread_pool(std::size_t threads = std::thread::hardware_concurrency()) {
+    if (threads == 0) {
+      threads = 1;
+    }
+    workers.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+      workers.emplace_back([this] {
+        while (task *t = queue.wait_pop()) {
+          t->complete(t, true);
+        }
+      });
+    }
+  }
+
+  thread_pool(thread_pool const &) = delete;
+  thread_pool &operator=(thread_pool const &) = delete;
+
+  ~thread_pool() {
+    queue.close();
+    for (std::thread &worker : workers) {
+      worker.join();
+    }
+  }
+
+  void post(task &t) {
+    queue.push(t);
+  }
+
+ private:
+  detail::task_queue queue;
+  std::vector<std::thread> workers;
+};
+}
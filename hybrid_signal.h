@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <utility>
+#include "signals.h"
+#include "static_signal.h"
+
+namespace signals {
+
+template<typename Signal, auto... Handlers>
+struct basic_hybrid_signal;
+
+/*
+Сигнал из двух частей: обработчики Handlers, известные на этапе
+компиляции (см. static_signal), и обычный signal для слотов,
+подключаемых во время работы - отладочных, мониторинга и т.п.
+Эмиссия сначала вызывает обработчики прямыми вызовами, затем слоты
+динамической части; если к ней никто не подключён или она
+заблокирована, это стоит одной проверки: число слотов и block_all
+хранятся в одном слове.
+
+Динамическая часть - закрытый базовый класс signal: connect,
+connection, его disconnect и перемещение работают как обычно;
+block_all блокирует только её, обработчики вызываются всегда.
+Наружу открыты только пути эмиссии, которые вызывают и обработчики,
+поэтому hybrid_signal нельзя передать как signal&.
+Аргументы, объявленные rvalue-ссылкой, обработчики получают как
+const lvalue, забрать их может последний слот динамической части,
+а если слотов нет - последний обработчик.
+*/
+template<typename... Args, typename... Options, auto... Handlers>
+struct basic_hybrid_signal<signal<void(Args...), Options...>, Handlers...> : private signal<void(Args...), Options...> {
+  using dynamic_signal = signal<void(Args...), Options...>;
+  using static_part = static_signal<void(Args...), Handlers...>;
+
+  using typename dynamic_signal::allocator_type;
+  using typename dynamic_signal::slot_t;
+  using typename dynamic_signal::connection;
+  using typename dynamic_signal::shared_block;
+
+  using dynamic_signal::dynamic_signal;
+  using dynamic_signal::get_allocator;
+  using dynamic_signal::connect;
+  using dynamic_signal::connect_front;
+  using dynamic_signal::connect_back;
+  using dynamic_signal::connect_once;
+  using dynamic_signal::connect_n;
+  using dynamic_signal::block_all;
+  using dynamic_signal::unblock_all;
+  using dynamic_signal::blocked;
+#if defined(__cpp_impl_coroutine)
+  using dynamic_signal::next;
+  using dynamic_signal::emissions;
+#endif
+
+  void operator()(detail::call_arg_t<Args>... args) const {
+    if (!dynamic_signal::active()) {
+      static_part()(std::forward<detail::call_arg_t<Args>>(args)...);
+      return;
+    }
+    static_part().call_shared(std::forward<detail::call_arg_t<Args>>(args)...);
+    dynamic_signal::operator()(std::forward<detail::call_arg_t<Args>>(args)...);
+  }
+
+  /* Обработчики слушают всегда, поэтому factory не вызывается, только если их нет и нет слотов. */
+  template<typename Factory>
+  void emit_lazy(Factory &&factory) const {
+    if (has_slots()) {
+      detail::apply_made<Args...>(*this, std::invoke(std::forward<Factory>(factory)));
+    }
+  }
+
+  std::size_t slot_count() const noexcept {
+    return static_part::size + dynamic_signal::slot_count();
+  }
+
+  bool has_slots() const noexcept {
+    return static_part::size != 0 || dynamic_signal::has_slots();
+  }
+
+  /* Обработчики получают все payloads по очереди, затем слоты - как в signal::emit_batch. */
+  template<typename Range>
+  void emit_batch(Range &&payloads) const {
+    for (auto &&payload : payloads) {
+      std::apply([](auto &... args) { static_part().call_shared(static_cast<detail::call_arg_t<Args>>(args)...); },
+                 payload);
+    }
+    dynamic_signal::emit_batch(std::forward<Range>(payloads));
+  }
+};
+
+template<typename Signature, auto... Handlers>
+using hybrid_signal = basic_hybrid_signal<signal<Signature>, Handlers...>;
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <type_traits>
 #include <utility>
 #include <iterator>
@@ -12,8 +13,62 @@ list_element.
 */
 struct default_tag;
 
-template<typename Tag = default_tag>
-struct list_element {
+/*
+Политика размера списка. untracked_size (по умолчанию) ничего не
+добавляет ни к списку, ни к элементам. С tracked_size список хранит
+счётчик элементов, а size() работает за O(1). Элемент отвязывает себя
+сам, не зная списка, поэтому при tracked_size он помнит указатель на
+счётчик своего списка: элемент становится на указатель больше,
+а перенос элементов splice из другого списка - O(k) по их числу.
+Политика у списка и у его элементов должна совпадать.
+*/
+struct untracked_size {
+  static constexpr bool tracked = false;
+};
+
+struct tracked_size {
+  static constexpr bool tracked = true;
+};
+
+namespace detail {
+template<typename SizePolicy>
+struct element_size {
+  void leave() noexcept {}
+};
+
+template<>
+struct element_size<tracked_size> {
+  /* Вычитает элемент из счётчика списка, в котором он был. */
+  void leave() noexcept {
+    if (list_size != nullptr) {
+      --*list_size;
+      list_size = nullptr;
+    }
+  }
+
+  std::size_t *list_size = nullptr;
+};
+
+template<typename SizePolicy>
+struct list_size {
+  template<typename E>
+  void enter(E &) noexcept {}
+};
+
+template<>
+struct list_size<tracked_size> {
+  template<typename E>
+  void enter(E &e) noexcept {
+    e.list_size = &count;
+    ++count;
+  }
+
+  std::size_t count = 0;
+};
+}
+
+template<typename Tag = default_tag, typename SizePolicy = untracked_size>
+struct list_element : detail::element_size<SizePolicy> {
   list_element *next;
   list_element *prev;
 
@@ -36,11 +91,16 @@ struct list_element {
 
     next = this;
     prev = this;
+    this->leave();
   };
 };
 
-template<typename T, typename Tag = default_tag>
-struct list {
+static_assert(sizeof(list_element<>) == 2 * sizeof(void *), "untracked_size must not grow list elements");
+
+template<typename T, typename Tag = default_tag, typename SizePolicy = untracked_size>
+struct list : detail::list_size<SizePolicy> {
+  using element = list_element<Tag, SizePolicy>;
+
   template<typename E>
   struct list_iterator {
     using iterator_category = std::bidirectional_iterator_tag;
@@ -94,24 +154,27 @@ struct list {
     Это важно иметь этот конструктор private, чтобы итератор нельзя было создать
     от nullptr.
     */
-    explicit list_iterator(list_element<Tag> *cur) noexcept: current(cur) {}
+    explicit list_iterator(element *cur) noexcept: current(cur) {}
     friend list;
     /*
     Хранить list_element*, а не T* важно.
     Иначе нельзя будет создать list_iterator для
     end().
     */
-    list_element<Tag> *current;
+    element *current;
   };
 
   using iterator = list_iterator<T>;
   using const_iterator = list_iterator<const T>;
 
-  static_assert(std::is_convertible_v<T &, list_element<Tag> &>,
+  static_assert(std::is_convertible_v<T &, element &>,
                 "value type is not convertible to list_element");
 
-  static void swap(list_element<Tag> &node1, list_element<Tag> &node2) {
+  static void swap(element &node1, element &node2) {
     using std::swap;
+    if constexpr (SizePolicy::tracked) {
+      swap(node1.list_size, node2.list_size);
+    }
     swap(node1.prev, node2.prev);
     swap(node1.prev->next, node2.prev->next);
     swap(node1.next, node2.next);
@@ -125,8 +188,7 @@ struct list {
   list(list const &) = delete;
 
   list(list &&cur_list) noexcept: list() {
-    swap(fake_node, cur_list.fake_node);
-    cur_list.clear();
+    splice(end(), cur_list);
   }
 
   ~list() {
@@ -136,16 +198,34 @@ struct list {
 
   list &operator=(list &&cur_list) noexcept {
     if (this != &cur_list) {
-      swap(fake_node, cur_list.fake_node);
-      cur_list.clear();
+      clear();
+      splice(end(), cur_list);
     }
     return *this;
   }
 
   void clear() noexcept {
-    while (!empty()) {
-      pop_back();
+    erase(begin(), end());
+  }
+
+  /*
+  Отсоединяет все элементы от списка за O(1), не трогая их по одному.
+  Элементы остаются связанными друг с другом в кольцо без фиктивного
+  узла, а unlink() по-прежнему работает за O(1) и просто вынимает
+  элемент из этого кольца. is_linked() истинно, пока в кольце больше
+  одного элемента; единственный элемент замыкается сам на себя и
+  ничем не отличается от отвязанного. Обходить кольцо и вставлять его
+  элементы куда-либо, не отвязав их, нельзя.
+  */
+  void clear_unsafe_detach() noexcept {
+    static_assert(!SizePolicy::tracked, "detached elements would still refer to the list size");
+    if (empty()) {
+      return;
     }
+    fake_node.next->prev = fake_node.prev;
+    fake_node.prev->next = fake_node.next;
+    fake_node.next = &fake_node;
+    fake_node.prev = &fake_node;
   }
 
   /*
@@ -157,6 +237,7 @@ struct list {
     get_list(node)->prev = fake_node.prev;
     get_list(node)->next = &fake_node;
     fake_node.prev = get_list(node);
+    this->enter(*get_list(node));
   }
 
   void pop_back() noexcept {
@@ -176,6 +257,7 @@ struct list {
     get_list(node)->next = fake_node.next;
     get_list(node)->prev = &fake_node;
     fake_node.next = get_list(node);
+    this->enter(*get_list(node));
   }
   void pop_front() noexcept {
     fake_node.next->unlink();
@@ -192,6 +274,12 @@ struct list {
     return fake_node.next == &fake_node;
   }
 
+  /* Число элементов, O(1). Есть только у списков с tracked_size. */
+  std::size_t size() const noexcept {
+    static_assert(SizePolicy::tracked, "size() requires intrusive::tracked_size");
+    return this->count;
+  }
+
   iterator begin() noexcept {
     return iterator(fake_node.next);
   }
@@ -203,7 +291,7 @@ struct list {
     return iterator(&fake_node);
   }
   const_iterator end() const noexcept {
-    return const_iterator(const_cast<list_element<Tag> *>(&fake_node));
+    return const_iterator(const_cast<element *>(&fake_node));
   }
 
   iterator insert(const_iterator pos, T &node) noexcept {
@@ -213,6 +301,7 @@ struct list {
     get_list(node)->next = &*pos_non_const;
     get_list(node)->prev = pos_non_const->prev;
     pos_non_const->prev = get_list(node);
+    this->enter(*get_list(node));
     return iterator(get_list(node));
   }
 
@@ -224,6 +313,29 @@ struct list {
     return cur;
   }
 
+  /*
+  Удаляет элементы [first, last). Соседи связываются один раз,
+  после чего каждый удалённый элемент только сбрасывает свои указатели.
+  */
+  iterator erase(const_iterator first, const_iterator last) noexcept {
+    element *cur = non_const_transform(first).current;
+    element *stop = non_const_transform(last).current;
+    if (cur == stop) {
+      return iterator(stop);
+    }
+
+    cur->prev->next = stop;
+    stop->prev = cur->prev;
+    while (cur != stop) {
+      element *next = cur->next;
+      cur->next = cur;
+      cur->prev = cur;
+      cur->leave();
+      cur = next;
+    }
+    return iterator(stop);
+  }
+
   void splice(const_iterator pos, list &l, const_iterator first, const_iterator last) noexcept {
     if (first == last) {
       return;
@@ -232,23 +344,41 @@ struct list {
     iterator first_non_const = non_const_transform(first);
     iterator last_non_const = non_const_transform(last);
 
+    if constexpr (SizePolicy::tracked) {
+      if (&l != this) {
+        for (element *cur = first_non_const.current; cur != last_non_const.current; cur = cur->next) {
+          cur->leave();
+          this->enter(*cur);
+        }
+      }
+    }
+
     pos_non_const->prev->next = &*first_non_const;
 
     first_non_const->prev->next = &*last_non_const;
     last_non_const->prev->next = &*pos_non_const;
 
-    list_element<Tag> *tmp = first_non_const->prev;
+    element *tmp = first_non_const->prev;
     first_non_const->prev = pos_non_const->prev;
     pos_non_const->prev = last_non_const->prev;
     last_non_const->prev = tmp;
   }
 
-  iterator as_iterator(T &element) noexcept {
-    return iterator(static_cast<list_element<Tag> *>(&element));
+  /*
+  Переносит все элементы l перед pos: за O(1) без учёта размера,
+  за O(k) по числу элементов l при tracked_size - каждый переносимый
+  элемент перезаписывает свою ссылку на счётчик.
+  */
+  void splice(const_iterator pos, list &l) noexcept {
+    splice(pos, l, l.begin(), l.end());
+  }
+
+  iterator as_iterator(T &value) noexcept {
+    return iterator(static_cast<element *>(&value));
   }
 
-  const_iterator as_iterator(T &element) const noexcept {
-    return const_iterator(static_cast<list_element<Tag> *>(&element));
+  const_iterator as_iterator(T &value) const noexcept {
+    return const_iterator(static_cast<element *>(&value));
   }
 
  private:
@@ -256,10 +386,10 @@ struct list {
     return iterator(cur->prev->next);
   }
 
-  static list_element<Tag> *get_list(T &node) {
-    return static_cast<list_element<Tag> *>(&node);
+  static element *get_list(T &node) {
+    return static_cast<element *>(&node);
   }
 
-  list_element<Tag> fake_node;
+  element fake_node;
 };
 }
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "executor.h"
+#include "small_function.h"
+
+namespace signals {
+namespace detail {
+template<typename Slot>
+struct slot_signature;
+
+template<typename R, typename... Args, std::size_t BufferSize, typename Alloc>
+struct slot_signature<small_function<R(Args...), BufferSize, Alloc>> {
+  using result = R;
+
+  template<template<typename...> typename T>
+  using apply = T<Args...>;
+};
+
+/* Может ли сигнал вызывать один слот из нескольких потоков сразу. */
+template<typename Signal, typename = void>
+struct concurrent_emission : std::false_type {};
+
+template<typename Signal>
+struct concurrent_emission<Signal, std::enable_if_t<Signal::concurrent_emission>> : std::true_type {};
+
+struct no_lock {
+  void lock() noexcept {}
+  void unlock() noexcept {}
+};
+
+/*
+Общее состояние отложенного подключения: пользовательский слот,
+флаг подключённости и пул сообщений. Им владеют слот внутри сигнала
+и каждое сообщение в очереди исполнителя, состояние разрушается
+вместе с последним из них.
+
+Сообщения не возвращаются в кучу: исполнитель возвращает их в стек
+released (из любого потока), а эмиссия забирает его целиком в свой
+кэш, когда кэш пуст. Забирать стек целиком, а не по одному элементу,
+нужно, чтобы не возникало ABA. Кэш принадлежит эмиссиям: если сигнал
+эмитит из нескольких потоков сразу (Concurrent), его защищает мьютекс.
+*/
+template<bool Concurrent, typename Executor, typename F, typename... Args>
+struct queued_state {
+  struct message : task {
+    explicit message(queued_state *state) noexcept : task{&queued_state::complete}, state(state) {}
+
+    queued_state *state;
+    message *next_free = nullptr;
+    std::optional<std::tuple<std::decay_t<Args>...>> args;
+  };
+
+  queued_state(Executor &ex, F slot) : ex(&ex), slot(std::move(slot)) {}
+
+  ~queued_state() {
+    free_list(cache);
+    free_list(released.load(std::memory_order_acquire));
+  }
+
+  template<typename... As>
+  void post(As &&... as) {
+    message *m = acquire();
+    refs.fetch_add(1, std::memory_order_relaxed);
+    try {
+      m->args.emplace(std::forward<As>(as)...);
+      ex->post(*m);
+    } catch (...) {
+      m->args.reset();
+      release(m);
+      refs.fetch_sub(1, std::memory_order_relaxed);
+      throw;
+    }
+  }
+
+  void disconnect() noexcept {
+    connected.store(false, std::memory_order_release);
+    unref();
+  }
+
+ private:
+  /*
+  Сообщение передаёт слоту свою копию аргументов, поэтому аргументы,
+  объявленные по значению, отдаются как rvalue.
+  */
+  template<typename T>
+  using delivered_t = std::conditional_t<std::is_lvalue_reference_v<T>, std::decay_t<T> &, std::decay_t<T> &&>;
+
+  static void complete(task *t, bool run) {
+    message *m = static_cast<message *>(t);
+    queued_state *state = m->state;
+    struct recycle {
+      ~recycle() {
+        m->args.reset();
+        state->release(m);
+        state->unref();
+      }
+
+      message *m;
+      queued_state *state;
+    } guard{m, state};
+
+    if (run && state->connected.load(std::memory_order_acquire)) {
+      std::apply([state](auto &... args) { std::invoke(state->slot, static_cast<delivered_t<Args>>(args)...); },
+                 *m->args);
+    }
+  }
+
+  message *acquire() {
+    {
+      std::lock_guard<cache_lock_t> guard(cache_lock);
+      if (cache == nullptr) {
+        cache = released.exchange(nullptr, std::memory_order_acquire);
+      }
+      if (cache != nullptr) {
+        message *m = cache;
+        cache = m->next_free;
+        return m;
+      }
+    }
+    return new message(this);
+  }
+
+  void release(message *m) noexcept {
+    m->next_free = released.load(std::memory_order_relaxed);
+    while (!released.compare_exchange_weak(m->next_free, m, std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+    }
+  }
+
+  void unref() noexcept {
+    if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+
+  static void free_list(message *m) noexcept {
+    while (m != nullptr) {
+      delete std::exchange(m, m->next_free);
+    }
+  }
+
+  Executor *ex;
+  F slot;
+  std::atomic<std::size_t> refs{1};
+  std::atomic<bool> connected{true};
+  std::atomic<message *> released{nullptr};
+
+  using cache_lock_t = std::conditional_t<Concurrent, std::mutex, no_lock>;
+  cache_lock_t cache_lock;
+  message *cache = nullptr;
+};
+
+/* Слот, который кладёт аргументы в сообщение и отправляет его исполнителю. */
+template<bool Concurrent, typename Executor, typename F, typename... Args>
+struct queued_slot {
+  queued_slot(Executor &ex, F slot) : state(new queued_state<Concurrent, Executor, F, Args...>(ex, std::move(slot))) {}
+
+  queued_slot(queued_slot &&other) noexcept : state(std::exchange(other.state, nullptr)) {}
+
+  queued_slot &operator=(queued_slot &&) = delete;
+
+  ~queued_slot() {
+    if (state != nullptr) {
+      state->disconnect();
+    }
+  }
+
+  template<typename... As>
+  void operator()(As &&... as) const {
+    state->post(std::forward<As>(as)...);
+  }
+
+ private:
+  queued_state<Concurrent, Executor, F, Args...> *state;
+};
+
+template<bool Concurrent, typename Executor, typename F>
+struct bind_queued_slot {
+  template<typename... Args>
+  using type = queued_slot<Concurrent, Executor, F, Args...>;
+};
+}
+
+/*
+Подключает к sig слот f, который выполняется не внутри эмиссии,
+а исполнителем ex (см. executor.h). Эмиссия копирует аргументы
+в сообщение и отправляет его исполнителю. Сообщения берутся
+из пула подключения, поэтому после разогрева эмиссия не аллоцирует.
+
+Обычный сигнал эмитит из одного потока за раз, а у сигналов
+с concurrent_emission (concurrent_signal) эмиссии из разных потоков
+берут сообщения из пула под мьютексом.
+
+Если подключение разорвано до доставки, сообщение отбрасывается.
+Вызов, который исполнитель уже начал, disconnect не прерывает и не
+дожидается. Исполнитель должен пережить все отправленные сообщения.
+*/
+template<typename Signal, typename Executor, typename F>
+typename Signal::connection connect_queued(Signal &sig, Executor &ex, F &&f) {
+  using slot_t = typename Signal::slot_t;
+  static_assert(std::is_void_v<typename detail::slot_signature<slot_t>::result>,
+                "queued slots cannot return results");
+  using queued = typename detail::slot_signature<slot_t>::template apply<
+      detail::bind_queued_slot<detail::concurrent_emission<Signal>::value, Executor, std::decay_t<F>>::template type>;
+  return sig.connect(queued(ex, std::forward<F>(f)));
+}
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "executor.h"
+
+namespace signals {
+namespace detail {
+/* Корутина возобновляется прямо внутри эмиссии. */
+struct inline_resume {};
+
+/*
+Что возвращает co_await: ничего для сигнала без аргументов,
+сам аргумент для сигнала с одним аргументом, иначе кортеж.
+*/
+template<typename Values>
+auto take_emission(Values &values) {
+  if constexpr (std::tuple_size_v<Values> == 0) {
+    return;
+  } else if constexpr (std::tuple_size_v<Values> == 1) {
+    return std::get<0>(std::move(values));
+  } else {
+    return std::move(values);
+  }
+}
+
+template<typename Values>
+using emission_result_t = decltype(take_emission(std::declval<Values &>()));
+}
+
+/*
+Результат signal::next(): co_await приостанавливает корутину до
+следующей эмиссии и возвращает её аргументы (их копии). Ожидание
+- это обычное подключение внутри awaiter, который лежит в кадре
+корутины, поэтому оно ничего не аллоцирует. Подключение
+разрывается при первой эмиссии.
+
+Без исполнителя корутина возобновляется внутри слота, то есть
+посреди эмиссии; с исполнителем - задачей, отправленной ему
+(см. executor.h). Если сигнал разрушится раньше эмиссии или
+исполнитель отменит задачу, корутина так и останется приостановленной.
+*/
+template<typename Signal, typename Executor, typename... Args>
+struct next_emission {
+  using values_t = std::tuple<std::decay_t<Args>...>;
+
+  next_emission(Signal &sig, Executor *ex) noexcept : sig(&sig), ex(ex) {}
+
+  bool await_ready() const noexcept {
+    return false;
+  }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    job.handle = handle;
+    conn = sig->connect([self = this](auto &&... args) { self->deliver(std::forward<decltype(args)>(args)...); });
+  }
+
+  detail::emission_result_t<values_t> await_resume() {
+    return detail::take_emission(*values);
+  }
+
+ private:
+  struct resume_task : task {
+    resume_task() noexcept : task{&resume_task::complete} {}
+
+    static void complete(task *t, bool run) {
+      if (run) {
+        static_cast<resume_task *>(t)->handle.resume();
+      }
+    }
+
+    std::coroutine_handle<> handle;
+  };
+
+  /* Слот разрушается disconnect, поэтому дальше используется только this. */
+  template<typename... As>
+  void deliver(As &&... as) {
+    values.emplace(std::forward<As>(as)...);
+    conn.disconnect();
+    if constexpr (std::is_same_v<Executor, detail::inline_resume>) {
+      job.handle.resume();
+    } else {
+      ex->post(job);
+    }
+  }
+
+  Signal *sig;
+  Executor *ex;
+  typename Signal::connection conn;
+  std::optional<values_t> values;
+  resume_task job;
+};
+
+/*
+Результат signal::emissions(): асинхронный поток эмиссий. Подключение
+живёт, пока жив поток, аргументы эмиссий копируются в очередь, а
+co_await stream.next() забирает из неё следующую эмиссию или ждёт её.
+Ожидающая корутина возобновляется внутри эмиссии. Поток нельзя
+перемещать: слот ссылается на него.
+*/
+template<typename Signal, typename... Args>
+struct emission_stream {
+  using values_t = std::tuple<std::decay_t<Args>...>;
+
+  explicit emission_stream(Signal &sig)
+      : conn(sig.connect([self = this](auto &&... args) { self->push(std::forward<decltype(args)>(args)...); })) {}
+
+  emission_stream(emission_stream const &) = delete;
+  emission_stream &operator=(emission_stream const &) = delete;
+
+  struct awaiter {
+    bool await_ready() const noexcept {
+      return !stream->pending.empty();
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) noexcept {
+      stream->waiting = handle;
+    }
+
+    detail::emission_result_t<values_t> await_resume() {
+      values_t values = std::move(stream->pending.front());
+      stream->pending.pop_front();
+      return detail::take_emission(values);
+    }
+
+    emission_stream *stream;
+  };
+
+  awaiter next() noexcept {
+    return awaiter{this};
+  }
+
+  /* Число эмиссий, которые ещё никто не забрал. */
+  std::size_t pending_count() const noexcept {
+    return pending.size();
+  }
+
+ private:
+  template<typename... As>
+  void push(As &&... as) {
+    pending.emplace_back(std::forward<As>(as)...);
+    if (waiting) {
+      std::exchange(waiting, nullptr).resume();
+    }
+  }
+
+  std::deque<values_t> pending;
+  std::coroutine_handle<> waiting;
+  typename Signal::connection conn;
+};
+}
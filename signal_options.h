@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace signals {
+/*
+Опции сигналов передаются списком типов после сигнатуры:
+signal<void(int), slot_buffer<64>>. Каждая опция объявляет
+option_kind, по которому её можно найти среди остальных.
+Порядок опций не важен, опция, не указанная явно, берётся
+по умолчанию.
+*/
+struct slot_buffer_option;
+
+/* Размер встроенного буфера под слот внутри connection. */
+template<std::size_t Size>
+struct slot_buffer {
+  using option_kind = slot_buffer_option;
+  static constexpr std::size_t size = Size;
+};
+
+using default_slot_buffer = slot_buffer<32>;
+
+struct slot_allocator_option;
+
+/*
+Аллокатор для всего, что сигнал размещает в куче: слотов, которые
+не поместились во встроенный буфер, и служебных структур. Сигнал
+с аллокатором, хранящим состояние, создаётся конструктором,
+принимающим allocator_type.
+*/
+template<typename Alloc>
+struct slot_allocator {
+  using option_kind = slot_allocator_option;
+  using type = Alloc;
+};
+
+using default_slot_allocator = slot_allocator<std::allocator<std::byte>>;
+
+struct teardown_option;
+
+/*
+Что делает деструктор сигнала с подключениями. eager_teardown
+(по умолчанию) отвязывает их и сразу разрушает слоты - за O(N).
+deferred_teardown отсоединяет весь список за O(1): подключения
+узнают о смерти сигнала через общий блок управления, а каждый слот
+разрушается вместе со своим connection. Цена - блок управления
+в куче на каждый сигнал и счётчик ссылок в connect/disconnect.
+*/
+struct eager_teardown {
+  using option_kind = teardown_option;
+  static constexpr bool deferred = false;
+};
+
+struct deferred_teardown {
+  using option_kind = teardown_option;
+  static constexpr bool deferred = true;
+};
+
+struct instrumentation_option;
+
+/*
+Сбор статистики эмиссий (см. signal_stats.h). no_instrumentation
+(по умолчанию) не добавляет к сигналу ни кода, ни данных.
+stats_instrumentation считает эмиссии, подключения и отключения,
+в том числе сделанные во время эмиссии, глубину вложенности эмиссий
+и строит гистограммы времени вызова каждого слота. Сигнал с ней
+регистрируется в stats_registry.
+*/
+struct no_instrumentation {
+  using option_kind = instrumentation_option;
+  static constexpr bool enabled = false;
+};
+
+struct stats_instrumentation {
+  using option_kind = instrumentation_option;
+  static constexpr bool enabled = true;
+};
+
+struct exception_option;
+
+/*
+Что эмиссия делает с исключениями слотов. propagate_exceptions
+(по умолчанию) выпускает исключение наружу, оставшиеся слоты не
+вызываются. collect_exceptions вызывает все слоты, а после эмиссии
+бросает emission_error со всеми пойманными исключениями; только для
+сигналов без результата. noexcept_slots принимает только слоты,
+объявленные noexcept, и делает эмиссию noexcept.
+*/
+struct propagate_exceptions {
+  using option_kind = exception_option;
+  static constexpr bool collect = false;
+  static constexpr bool nothrow = false;
+};
+
+struct collect_exceptions {
+  using option_kind = exception_option;
+  static constexpr bool collect = true;
+  static constexpr bool nothrow = false;
+};
+
+struct noexcept_slots {
+  using option_kind = exception_option;
+  static constexpr bool collect = false;
+  static constexpr bool nothrow = true;
+};
+
+namespace detail {
+template<typename Option, typename = void>
+struct option_kind {
+  using type = void;
+};
+
+template<typename Option>
+struct option_kind<Option, std::void_t<typename Option::option_kind>> {
+  using type = typename Option::option_kind;
+};
+
+/* Опция одного из видов, перечисленных выше. */
+template<typename Option>
+constexpr bool is_known_option_v = std::is_same_v<typename option_kind<Option>::type, slot_buffer_option>
+    || std::is_same_v<typename option_kind<Option>::type, slot_allocator_option>
+    || std::is_same_v<typename option_kind<Option>::type, teardown_option>
+    || std::is_same_v<typename option_kind<Option>::type, instrumentation_option>
+    || std::is_same_v<typename option_kind<Option>::type, exception_option>;
+
+template<typename Kind, typename Default, typename... Options>
+struct find_option {
+  using type = Default;
+};
+
+template<typename Kind, typename Default, typename Option, typename... Options>
+struct find_option<Kind, Default, Option, Options...> {
+  using type = std::conditional_t<std::is_same_v<typename option_kind<Option>::type, Kind>,
+                                  Option,
+                                  typename find_option<Kind, Default, Options...>::type>;
+};
+
+template<typename Kind, typename Default, typename... Options>
+using find_option_t = typename find_option<Kind, Default, Options...>::type;
+}
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace signals {
+/*
+Гистограмма длительностей с логарифмическими бакетами: бакет i
+считает вызовы длительностью [2^i, 2^(i+1)) наносекунд, последний
+бакет - всё, что дольше.
+*/
+struct latency_histogram {
+  static constexpr std::size_t buckets = 32;
+
+  void record(std::chrono::nanoseconds duration) noexcept {
+    auto ns = static_cast<std::uint64_t>(std::max<std::chrono::nanoseconds::rep>(duration.count(), 1));
+    std::size_t bucket = 0;
+    while (ns > 1 && bucket + 1 < buckets) {
+      ns >>= 1;
+      ++bucket;
+    }
+    ++counts[bucket];
+  }
+
+  std::uint64_t total() const noexcept {
+    std::uint64_t sum = 0;
+    for (std::uint64_t c : counts) {
+      sum += c;
+    }
+    return sum;
+  }
+
+  latency_histogram &operator+=(latency_histogram const &other) noexcept {
+    for (std::size_t i = 0; i < buckets; ++i) {
+      counts[i] += other.counts[i];
+    }
+    return *this;
+  }
+
+  std::array<std::uint64_t, buckets> counts{};
+};
+
+struct slot_stats {
+  std::uint64_t calls = 0;
+  latency_histogram latency;
+};
+
+struct signal_stats {
+  std::string name;
+  std::uint64_t emits = 0;
+  std::uint64_t connects = 0;
+  std::uint64_t disconnects = 0;
+  /* Отключения, случившиеся, пока сигнал эмитился. */
+  std::uint64_t disconnects_in_emit = 0;
+  /* Текущая и наибольшая глубина вложенных эмиссий. */
+  std::size_t depth = 0;
+  std::size_t max_depth = 0;
+  /* Все вызовы слотов сигнала, включая уже отключённые слоты. */
+  latency_histogram slot_latency;
+  /* Живые подключения в порядке вызова. Заполняется только в снимке. */
+  std::vector<slot_stats> slots;
+};
+
+namespace detail {
+struct stats_source {
+  virtual void collect(signal_stats &out) const = 0;
+
+ protected:
+  ~stats_source() = default;
+};
+}
+
+/*
+Реестр статистики всех инструментированных сигналов. Сигналы
+регистрируются в конструкторе и удаляются в деструкторе. Сами
+сигналы не потокобезопасны, поэтому snapshot нужно вызывать из
+того потока, в котором работают сигналы, статистику которых
+он читает.
+*/
+struct stats_registry {
+  static stats_registry &instance() {
+    static stats_registry registry;
+    return registry;
+  }
+
+  std::vector<signal_stats> snapshot() const {
+    std::lock_guard<std::mutex> lg(mutex);
+    std::vector<signal_stats> result(sources.size());
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+      sources[i]->collect(result[i]);
+    }
+    return result;
+  }
+
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lg(mutex);
+    return sources.size();
+  }
+
+  void add(detail::stats_source *source) {
+    std::lock_guard<std::mutex> lg(mutex);
+    sources.push_back(source);
+  }
+
+  void remove(detail::stats_source *source) noexcept {
+    std::lock_guard<std::mutex> lg(mutex);
+    sources.erase(std::remove(sources.begin(), sources.end(), source), sources.end());
+  }
+
+ private:
+  stats_registry() = default;
+
+  mutable std::mutex mutex;
+  std::vector<detail::stats_source *> sources;
+};
+
+namespace detail {
+/*
+Базы сигнала и подключения, хранящие статистику. Без инструментирования
+это пустые базы, которые не меняют размер сигнала и connection.
+*/
+template<bool Enabled>
+struct slot_instrumentation {};
+
+template<>
+struct slot_instrumentation<true> {
+  slot_stats stats;
+};
+
+template<bool Enabled, typename Signal>
+struct signal_instrumentation {};
+
+template<typename Signal>
+struct signal_instrumentation<true, Signal> : stats_source {
+  signal_instrumentation() {
+    stats_registry::instance().add(this);
+  }
+
+  signal_instrumentation(signal_instrumentation const &) = delete;
+  signal_instrumentation &operator=(signal_instrumentation const &) = delete;
+
+  ~signal_instrumentation() {
+    stats_registry::instance().remove(this);
+  }
+
+  /* Счётчики сигнала без статистики отдельных слотов. */
+  signal_stats const &stats() const noexcept {
+    return counters;
+  }
+
+  void set_name(std::string name) {
+    counters.name = std::move(name);
+  }
+
+ protected:
+  mutable signal_stats counters;
+
+ private:
+  void collect(signal_stats &out) const override {
+    out = counters;
+    static_cast<Signal const *>(this)->collect_slots(out.slots);
+  }
+};
+}
+}
@@ -1,135 +1,1266 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "combiners.h"
 #include <functional>
+#include <map>
+#include <memory_resource>
 #include "intrusive_list.h"
+#include "signal_options.h"
+#include "signal_stats.h"
+#include "small_function.h"
+#if defined(__cpp_impl_coroutine)
+#include "signal_awaitable.h"
+#endif
 
 namespace signals {
 
-template<typename T>
+template<typename T, typename... Options>
 struct signal;
 
-template<typename... Args>
-struct signal<void(Args...)> {
-  using slot_t = std::function<void (Args...)>;
+/* Исключения, которые бросили слоты во время эмиссии сигнала с collect_exceptions. */
+struct emission_error : std::exception {
+  explicit emission_error(std::vector<std::exception_ptr> errors) noexcept : errors(std::move(errors)) {}
 
-  struct connection : intrusive::list_element<struct connection_tag> {
+  char const *what() const noexcept override {
+    return "slots threw during signal emission";
+  }
+
+  std::vector<std::exception_ptr> errors;
+};
+
+namespace detail {
+/*
+Передаёт emit результат фабрики emit_lazy: для сигнала с одним
+аргументом - как есть, если он в этот аргумент превращается,
+иначе - распакованным через std::apply.
+*/
+template<typename... Args, typename Emit, typename Made>
+decltype(auto) apply_made(Emit const &emit, Made &&made) {
+  if constexpr (sizeof...(Args) == 1 && (std::is_convertible_v<Made &&, call_arg_t<Args>> && ...)) {
+    return emit(std::forward<Made>(made));
+  } else {
+    return std::apply([&emit](auto &&... args) -> decltype(auto) { return emit(std::forward<decltype(args)>(args)...); },
+                      std::forward<Made>(made));
+  }
+}
+
+/*
+Опция без option_kind - комбинатор: её можно вызвать парой
+input-итераторов по результатам слотов. Проверяется на R const *,
+поэтому опечатка в имени опции не становится комбинатором молча.
+*/
+template<typename Option, typename R>
+constexpr bool is_combiner_v = std::is_void_v<typename option_kind<Option>::type> && !std::is_void_v<R>
+    && std::is_invocable_v<Option &, R const *, R const *>;
+}
+
+/*
+Сигнал с сигнатурой R(Args...). Для R, отличного от void, результаты
+слотов сворачивает комбинатор (см. combiners.h) - опция без option_kind,
+по умолчанию combiners::last<R>. Результат эмиссии - результат
+комбинатора.
+
+Порядок вызова слотов: сначала подключённые через connect_front
+(последний подключённый - первым), затем группы connect(priority, ...)
+по убыванию приоритета, внутри группы - в порядке подключения,
+затем подключённые через connect_back в порядке подключения.
+connect(slot) - то же, что connect_front. Слоты, подключённые во время
+эмиссии любым из этих способов, она не вызывает; группа, в которой
+не осталось слотов, удаляется.
+*/
+template<typename R, typename... Args, typename... Options>
+struct signal<R(Args...), Options...>
+    : detail::signal_instrumentation<
+          detail::find_option_t<instrumentation_option, no_instrumentation, Options...>::enabled,
+          signal<R(Args...), Options...>> {
+  static_assert(!std::is_reference_v<R>, "slot results are cached by value");
+  static_assert(((detail::is_known_option_v<Options> || detail::is_combiner_v<Options, R>) && ...),
+                "unknown signal option: options declare option_kind, combiners take a pair of input iterators");
+
+  using allocator_type = typename detail::find_option_t<slot_allocator_option, default_slot_allocator, Options...>::type;
+  using slot_t = small_function<R(Args...),
+                                detail::find_option_t<slot_buffer_option, default_slot_buffer, Options...>::size,
+                                allocator_type>;
+  using combiner_t = detail::find_option_t<void, combiners::last<R>, Options...>;
+
+  static constexpr bool deferred_teardown =
+      detail::find_option_t<teardown_option, eager_teardown, Options...>::deferred;
+  static constexpr bool instrumented =
+      detail::find_option_t<instrumentation_option, no_instrumentation, Options...>::enabled;
+  static constexpr bool collect_exceptions =
+      detail::find_option_t<exception_option, propagate_exceptions, Options...>::collect;
+  static constexpr bool noexcept_slots =
+      detail::find_option_t<exception_option, propagate_exceptions, Options...>::nothrow;
+
+  static_assert(!collect_exceptions || std::is_void_v<R>, "collect_exceptions cannot combine slot results");
+
+ private:
+  static constexpr unsigned serial_bits = 48;
+  static constexpr std::uint64_t block_unit = std::uint64_t(1) << serial_bits;
+  static constexpr std::size_t blocked_bit = ~(~std::size_t(0) >> 1);
+
+  struct control_block;
+
+  /* Чем подключение считает свой сигнал. Разыменовывать sig нельзя: сигнала может уже не быть. */
+  using owner_t = std::conditional_t<deferred_teardown, control_block, signal>;
+
+  /*
+  Элементы списка connections: подключения и курсоры. У курсора
+  sig всегда nullptr, у подключённого connection - нет.
+  */
+  struct node : intrusive::list_element<struct connection_tag> {
+   protected:
+    friend signal;
+
+    owner_t *sig = nullptr;
+  };
+
+  /*
+  Курсор - либо позиция эмиссии (iteration_token), либо неподвижная
+  граница группы приоритета. У границы owner всегда nullptr.
+  */
+  struct cursor : node {
+    signal const *owner = nullptr;
+  };
+
+  /* Граница группы приоритета, помнит свой ключ в groups. */
+  struct group_boundary : cursor {
+    int priority = 0;
+  };
+
+  static bool is_emission(node const *n) noexcept {
+    return n->sig == nullptr && static_cast<cursor const *>(n)->owner != nullptr;
+  }
+
+  using connection_t = intrusive::list<node, struct connection_tag>;
+
+  /*
+  При deferred_teardown список подключений живёт в блоке управления
+  в куче, а не в самом сигнале. Блок разделяют сигнал, подключения
+  и эмиссии: он освобождается последним из них, поэтому разрушенный
+  сигнал может оставить список с подключениями как есть.
+  */
+  struct control_block {
+    using block_alloc = typename std::allocator_traits<allocator_type>::template rebind_alloc<control_block>;
+
+    static control_block *make(signal *target, allocator_type const &alloc) {
+      block_alloc ba(alloc);
+      control_block *block = std::allocator_traits<block_alloc>::allocate(ba, 1);
+      return new(block) control_block{{}, alloc, 1, true, target, 0};
+    }
+
+    static void release(control_block *block) noexcept {
+      if (--block->refs == 0) {
+        block_alloc ba(block->alloc);
+        block->~control_block();
+        std::allocator_traits<block_alloc>::deallocate(ba, block, 1);
+      }
+    }
+
+    connection_t connections;
+    allocator_type alloc;
+    std::size_t refs;
+    bool alive;
+    signal *target;
+    std::size_t count;
+  };
+
+  using head_t = std::conditional_t<deferred_teardown, control_block *, connection_t>;
+
+ public:
+  struct connection;
+
+ private:
+  /* Слот подключения, который вызывает слот, оставшийся в перемещённом connection lender. */
+  struct lent_slot {
+    R operator()(detail::call_arg_t<Args>... args) const {
+      return lender->slot(std::forward<detail::call_arg_t<Args>>(args)...);
+    }
+
+    /* call_shared не забирает аргументы, поэтому снять const здесь безопасно. */
+    template<bool Shared = slot_t::movable_args, typename = std::enable_if_t<Shared>>
+    R operator()(detail::shared_arg_t<Args>... args) const {
+      return lender->slot.call_shared(const_cast<detail::call_arg_t<Args>>(args)...);
+    }
+
+    connection *lender;
+  };
+
+ public:
+  struct shared_block;
+
+  /*
+  disconnect и перемещение работают за O(1) независимо от числа
+  активных эмиссий: поправить указатель нужно только самой внутренней
+  из них, а внешние помнят позицию курсором внутри списка, поэтому
+  отвязывание соседнего элемента их не затрагивает.
+
+  Слот, который сейчас выполняется, перемещение не трогает: он
+  остаётся в старом connection, а новый вызывает его через lent_slot,
+  пока старый не разрушен или ему не присвоено другое подключение.
+  Поэтому старый connection нельзя разрушать, пока слот не вернул
+  управление.
+  */
+  struct connection : node, detail::slot_instrumentation<instrumented> {
     connection() = default;
 
-    connection(connection &&other) : sig(other.sig), slot(other.slot) {
-      safe_move(other);
+    connection(connection &&other) noexcept : detail::slot_instrumentation<instrumented>(std::move(other)) {
+      take(other);
     }
 
-    connection &operator=(connection &&other) {
+    connection &operator=(connection &&other) noexcept {
       if (this == &other) {
         return *this;
       }
 
       disconnect();
-      sig = other.sig;
-      slot = std::move(other.slot);
-      safe_move(other);
+      settle();
+      static_cast<detail::slot_instrumentation<instrumented> &>(*this) = std::move(other);
+      take(other);
 
       return *this;
     }
 
-    void disconnect() {
-      if (is_linked()) {
-        unlink();
-        slot = {};
-
-        for (iteration_token *tok = sig->top_token; tok != nullptr; tok = tok->next) {
-          if (tok->current != sig->connections.end() && &*tok->current == this) {
-            ++tok->current;
+    void disconnect() noexcept {
+      if (this->is_linked()) {
+        if (signal *target = live_signal(this->sig)) {
+          if constexpr (instrumented) {
+            ++target->counters.disconnects;
+            if (target->counters.depth != 0) {
+              ++target->counters.disconnects_in_emit;
+            }
           }
+          if (!target->groups.empty()) {
+            target->leave_group(*this);
+          }
+          target->step_back(*this);
+        }
+        this->unlink();
+        --this->sig->count;
+        owner_t *owner = std::exchange(this->sig, nullptr);
+        release_slot();
+        if constexpr (deferred_teardown) {
+          control_block::release(owner);
         }
-        sig = nullptr;
       }
     }
 
     ~connection() {
       disconnect();
+      release_holders();
+      settle();
+    }
+
+    /*
+    Пока подключение заблокировано, эмиссии пропускают его слот;
+    место в списке и сам слот остаются как есть. Блокировки
+    вкладываются: слот снова вызывается, когда каждому block
+    соответствует unblock.
+    */
+    void block() noexcept {
+      stamp += block_unit;
+    }
+
+    void unblock() noexcept {
+      if (blocked()) {
+        stamp -= block_unit;
+      }
+    }
+
+    bool blocked() const noexcept {
+      return stamp >= block_unit;
     }
 
    private:
-    connection(signal *sig, slot_t slot) noexcept : sig(sig), slot(std::move(slot)) {
-      sig->connections.push_front(*this);
+    connection(signal *sig, slot_t slot, typename connection_t::const_iterator pos) noexcept
+        : stamp(sig->next_serial++), slot(std::move(slot)) {
+      if constexpr (deferred_teardown) {
+        this->sig = sig->head;
+        ++sig->head->refs;
+      } else {
+        this->sig = sig;
+      }
+      sig->list().insert(pos, *this);
+      ++this->sig->count;
+      if constexpr (instrumented) {
+        ++sig->counters.connects;
+      }
+    }
+
+    friend shared_block;
+
+    /* Забирает у other слот, место в списке и shared_block. */
+    void take(connection &other) noexcept {
+      if (other.lends()) {
+        return;
+      }
+      stamp = other.stamp;
+      remaining = other.remaining;
+      take_slot(other);
+      replace(other);
+      release_holders();
+      adopt_holders(other);
+    }
+
+    /*
+    Слот other, который сейчас выполняется, остаётся на месте: this
+    получает lent_slot, а other запоминает, кому отдать слот потом.
+    */
+    void take_slot(connection &other) noexcept {
+      if (lent_slot *lent = other.slot.template target<lent_slot>()) {
+        lent->lender->heir = this;
+        slot = std::move(other.slot);
+      } else if (other.is_linked() && running(other)) {
+        slot = lent_slot{&other};
+        other.heir = this;
+      } else {
+        slot = std::move(other.slot);
+      }
+    }
+
+    static bool running(connection const &conn) noexcept {
+      signal *target = live_signal(conn.sig);
+      iteration_token const *tok = target != nullptr ? target->top_token : nullptr;
+      return tok != nullptr
+          && (tok->pos == &conn || (conn.next != tok->end && is_emission(static_cast<node const *>(conn.next))));
+    }
+
+    /* Перемещённый connection, который ещё хранит выполнявшийся слот. */
+    bool lends() const noexcept {
+      return !this->is_linked() && static_cast<bool>(slot);
+    }
+
+    /* Отдаёт одолженный слот наследнику: вызов, во время которого connection переместили, закончился. */
+    void settle() noexcept {
+      if (lends()) {
+        if (heir != nullptr) {
+          heir->slot = std::move(slot);
+        } else {
+          slot.reset();
+        }
+        remaining = 0;
+      }
+    }
+
+    /* Забирает слот; если он одолжен, тот, кто его одолжил, больше не отдаёт его сюда. */
+    slot_t release_slot() noexcept {
+      if (lent_slot *lent = slot.template target<lent_slot>()) {
+        lent->lender->heir = nullptr;
+      }
+      return std::move(slot);
     }
 
-    void safe_move(connection &other) {
+    /* shared_block на other переходят на this вместе с блокировками. */
+    void adopt_holders(connection &other) noexcept {
+      holders = std::exchange(other.holders, nullptr);
+      for (shared_block *b = holders; b != nullptr; b = b->next) {
+        b->conn = this;
+      }
+    }
+
+    /* Отпускает shared_block, когда подключение больше не это. */
+    void release_holders() noexcept {
+      while (holders != nullptr) {
+        std::exchange(holders, holders->next)->conn = nullptr;
+      }
+    }
+
+    /* Занимает место other в списке. */
+    void replace(connection &other) noexcept {
       if (other.is_linked()) {
-        other.sig->connections.insert(sig->connections.as_iterator(other), *this);
-        other.unlink();
-        for (iteration_token *tok = sig->top_token; tok != nullptr; tok = tok->next) {
-          if (tok->current != sig->connections.end() && &*tok->current == &other) {
-            tok->current = sig->connections.as_iterator(*this);
+        if (signal *target = live_signal(other.sig)) {
+          if (target->top_token != nullptr && target->top_token->pos == &other) {
+            target->top_token->pos = this;
           }
         }
+        this->sig = std::exchange(other.sig, nullptr);
+        this->prev = other.prev;
+        this->next = &other;
+        other.prev->next = this;
+        other.prev = this;
+        other.unlink();
       }
     }
 
-    friend signal<void(Args...)>;
+    /* Тратит один вызов слота connect_n; true, если этот вызов последний. */
+    bool spend_call() noexcept {
+      return remaining != 0 && --remaining == 0;
+    }
+
+    friend signal;
 
-    signal *sig;
+    /*
+    Младшие serial_bits бит - порядковый номер подключения (их хватает
+    на 2^48 подключений за жизнь сигнала): эмиссии не вызывают слоты,
+    подключённые после их начала. Старшие - число блокировок. Эмиссия
+    проверяет и то, и другое одним сравнением.
+    */
+    std::uint64_t stamp = 0;
     slot_t slot;
+    union {
+      /* Сколько вызовов осталось слоту connect_n; 0 - без ограничения. */
+      std::size_t remaining = 0;
+      /* Пока lends(): кому отдать слот. */
+      connection *heir;
+    };
+    /* shared_block, которые держат это подключение. */
+    shared_block *holders = nullptr;
+  };
+
+  /*
+  Блокирует подключение на время своей жизни. Копия блокирует его
+  ещё раз, поэтому слот вызывается снова, когда разрушены все копии.
+  Блокировки хранятся в подключении и переезжают вместе с ним при
+  перемещении. Если connection разрушен или ему присвоено другое
+  подключение, shared_block больше ничего не держит.
+  */
+  struct shared_block {
+    explicit shared_block(connection &conn) noexcept {
+      attach(&conn);
+    }
+
+    shared_block(shared_block const &other) noexcept {
+      attach(other.conn);
+    }
+
+    shared_block &operator=(shared_block const &) = delete;
+
+    ~shared_block() {
+      if (conn != nullptr) {
+        conn->unblock();
+        (prev != nullptr ? prev->next : conn->holders) = next;
+        if (next != nullptr) {
+          next->prev = prev;
+        }
+      }
+    }
+
+   private:
+    void attach(connection *target) noexcept {
+      conn = target;
+      if (conn != nullptr) {
+        conn->block();
+        next = std::exchange(conn->holders, this);
+        if (next != nullptr) {
+          next->prev = this;
+        }
+      }
+    }
+
+    friend connection;
+
+    connection *conn = nullptr;
+    shared_block *prev = nullptr;
+    shared_block *next = nullptr;
   };
 
-  using connection_t = intrusive::list<connection, struct connection_tag>;
+  signal() noexcept(!deferred_teardown) : signal(allocator_type()) {}
+
+  explicit signal(allocator_type const &alloc) noexcept(!deferred_teardown)
+      : head(make_head(this, alloc)), groups(alloc) {}
 
-  signal() noexcept = default;
+  explicit signal(combiner_t combiner, allocator_type const &alloc = allocator_type())
+      : head(make_head(this, alloc)), groups(alloc), combiner(std::move(combiner)) {}
+
+  allocator_type get_allocator() const noexcept {
+    return allocator_type(groups.get_allocator());
+  }
 
   signal(signal const &) = delete;
   signal &operator=(signal const &) = delete;
 
   ~signal() {
-    for (iteration_token *tok = top_token; tok != nullptr; tok = tok->next) {
-      if (tok->current != connections.end()) {
-        tok->sig = nullptr;
+    if (top_token != nullptr) {
+      top_token->owner = nullptr;
+    }
+    if constexpr (deferred_teardown) {
+      for (auto &group : groups) {
+        group.second.unlink();
+      }
+      back.unlink();
+      head->alive = false;
+      control_block::release(head);
+    } else {
+      while (!list().empty()) {
+        node &front = list().front();
+        front.unlink();
+        if (front.sig == nullptr) {
+          static_cast<cursor &>(front).owner = nullptr;
+        } else {
+          front.sig = nullptr;
+          static_cast<connection &>(front).release_slot();
+        }
       }
     }
+  }
+
+  /*
+  Слот может быть готовым slot_t или любым объектом, из которого
+  slot_t строится; во втором случае используется аллокатор сигнала.
+  */
+  template<typename F, typename = std::enable_if_t<std::is_constructible_v<slot_t, F>>>
+  connection connect(F &&slot) {
+    return connect_front(std::forward<F>(slot));
+  }
+
+  template<typename F, typename = std::enable_if_t<std::is_constructible_v<slot_t, F>>>
+  connection connect_front(F &&slot) {
+    return connection(this, make_slot(std::forward<F>(slot)), list().begin());
+  }
+
+  template<typename F, typename = std::enable_if_t<std::is_constructible_v<slot_t, F>>>
+  connection connect_back(F &&slot) {
+    slot_t made = make_slot(std::forward<F>(slot));
+    back_boundary();
+    return connection(this, std::move(made), list().end());
+  }
+
+  /*
+  Подключает функцию Function или метод Method объекта object
+  без промежуточного функтора (см. delegate в small_function.h).
+  */
+  template<auto Function>
+  connection connect() {
+    return connect(delegate<Function>());
+  }
+
+  template<auto Method, typename T>
+  connection connect(T *object) {
+    return connect(delegate<Method>(object));
+  }
+
+  /*
+  Подключает слот, который сигнал сам отключит после n вызовов
+  (connect_once - после первого). Эмиссия отключает его прямо перед
+  последним вызовом, поэтому вложенные эмиссии его уже не вызовут,
+  а connection остаётся действительным и после этого. Кроме счётчика
+  в connection, ничего не размещается.
+  */
+  template<typename F, typename = std::enable_if_t<std::is_constructible_v<slot_t, F>>>
+  connection connect_once(F &&slot) {
+    return connect_n(1, std::forward<F>(slot));
+  }
+
+  template<typename F, typename = std::enable_if_t<std::is_constructible_v<slot_t, F>>>
+  connection connect_n(std::size_t n, F &&slot) {
+    connection conn = n == 0 ? connection() : connect(std::forward<F>(slot));
+    conn.remaining = n;
+    return conn;
+  }
+
+  /* Подключает слот в конец группы priority. O(log G) по числу групп. */
+  template<typename F, typename = std::enable_if_t<std::is_constructible_v<slot_t, F>>>
+  connection connect(int priority, F &&slot) {
+    slot_t made = make_slot(std::forward<F>(slot));
+    auto group = groups.try_emplace(priority).first;
+    auto next = std::next(group);
+    node &before = next == groups.end() ? back_boundary() : next->second;
+    if (!group->second.is_linked()) {
+      group->second.priority = priority;
+      list().insert(list().as_iterator(before), group->second);
+    }
+    return connection(this, std::move(made), list().as_iterator(before));
+  }
 
-    while (!connections.empty()) {
-      connections.front().slot = {};
-      connections.front().sig = nullptr;
-      connections.front().unlink();
+  /*
+  Аргументы, объявленные по значению, передаются всем слотам по
+  одной const-ссылке без копирования. Аргументы, объявленные
+  rvalue-ссылкой, все слоты, кроме последнего, получают как const
+  lvalue, а последний - как rvalue и может забрать их себе.
+  */
+  auto operator()(detail::call_arg_t<Args>... args) const noexcept(noexcept_slots && std::is_void_v<R>) {
+    if constexpr (!std::is_void_v<R>) {
+      return combine(std::forward<detail::call_arg_t<Args>>(args)...);
+    } else {
+      emit(std::forward<detail::call_arg_t<Args>>(args)...);
+    }
+  }
+
+  /*
+  Вызывает factory и эмитит то, что она вернула, только если к сигналу
+  подключён хотя бы один слот. factory возвращает кортеж аргументов
+  (что-то, что принимает std::apply), а для сигнала с одним аргументом
+  может вернуть и сам аргумент. Без слотов результат - то, что
+  комбинатор возвращает для пустой последовательности.
+  */
+  template<typename Factory>
+  auto emit_lazy(Factory &&factory) const {
+    if (!active()) {
+      if constexpr (!std::is_void_v<R>) {
+        return combiner_t(combiner)(slot_iterator(), slot_iterator());
+      } else {
+        return;
+      }
     }
+    return detail::apply_made<Args...>(*this, std::invoke(std::forward<Factory>(factory)));
+  }
+
+  /*
+  Блокирует все слоты сигнала: эмиссия сводится к одной проверке и
+  никого не вызывает, комбинатор получает пустую последовательность.
+  Подключения и их собственные блокировки не меняются.
+  */
+  void block_all() noexcept {
+    counter() |= blocked_bit;
+  }
+
+  void unblock_all() noexcept {
+    counter() &= ~blocked_bit;
+  }
+
+  bool blocked() const noexcept {
+    return (counter() & blocked_bit) != 0;
+  }
+
+  /* Число подключённых слотов. Поддерживается при connect и disconnect, O(1). */
+  std::size_t slot_count() const noexcept {
+    return counter() & ~blocked_bit;
+  }
+
+  bool has_slots() const noexcept {
+    return slot_count() != 0;
+  }
+
+  /*
+  Вызовет ли эмиссия хоть кого-нибудь, без учёта блокировок отдельных
+  подключений: есть слоты и нет block_all. Одно сравнение.
+  */
+  bool active() const noexcept {
+    return counter() - 1 < blocked_bit - 1;
+  }
+
+#if defined(__cpp_impl_coroutine)
+  /*
+  co_await sig.next() ждёт следующую эмиссию и возвращает её аргументы,
+  co_await sig.next(ex) возобновляет корутину через исполнитель ex.
+  emissions() - поток всех последующих эмиссий. См. signal_awaitable.h.
+  */
+  next_emission<signal, detail::inline_resume, Args...> next() {
+    static_assert(std::is_void_v<R>, "awaited slots cannot return results");
+    return next_emission<signal, detail::inline_resume, Args...>(*this, nullptr);
   }
 
-  connection connect(std::function<void(Args...)> slot) noexcept {
-    return connection(this, std::move(slot));
+  template<typename Executor>
+  next_emission<signal, Executor, Args...> next(Executor &ex) {
+    static_assert(std::is_void_v<R>, "awaited slots cannot return results");
+    return next_emission<signal, Executor, Args...>(*this, &ex);
   }
 
-  void operator()(Args... args) const {
+  emission_stream<signal, Args...> emissions() {
+    static_assert(std::is_void_v<R>, "awaited slots cannot return results");
+    return emission_stream<signal, Args...>(*this);
+  }
+#endif
+
+  /*
+  Доставляет все наборы аргументов из payloads (кортежей Args...)
+  за один проход по списку подключений. Порядок slot-major: каждому
+  слоту по очереди передаются все payloads в порядке диапазона,
+  затем следующему слоту. Слоты, подключённые во время emit_batch,
+  не вызываются. Слот, отключённый или перемещённый во время
+  обработки, больше не получает payloads этого вызова.
+  */
+  template<typename Range>
+  void emit_batch(Range &&payloads) const {
+    static_assert(std::is_void_v<R>, "emit_batch does not combine slot results");
+
+    count_emit();
+    if (!active() || std::begin(payloads) == std::end(payloads)) {
+      return;
+    }
+
     iteration_token tok(this);
+    nesting_scope nesting(tok);
+    exception_sink errors;
 
-    while (tok.current != connections.end()) {
-      auto copy = tok.current;
-      tok.current++;
-      copy->slot(args...);
+    while (connection *conn = tok.advance()) {
+      for (auto &&payload : payloads) {
+        errors.run([conn, &tok, &payload] {
+          std::apply(
+              [conn, &tok](auto &... args) {
+                [[maybe_unused]] slot_timer timer(conn, tok);
+                if (conn->spend_call()) {
+                  retire(conn).call_shared(static_cast<detail::call_arg_t<Args>>(args)...);
+                } else {
+                  conn->slot.call_shared(static_cast<detail::call_arg_t<Args>>(args)...);
+                }
+              },
+              payload);
+        });
 
-      if (tok.sig == nullptr) {
-        return;
+        if (tok.destroyed()) {
+          errors.rethrow();
+          return;
+        }
+        if (!tok.follows(conn)) {
+          break;
+        }
       }
     }
+    errors.rethrow();
   }
 
  private:
-  struct iteration_token {
+  /*
+  Позиция эмиссии - элемент списка connections, стоящий перед
+  следующим слотом, который нужно вызвать.
+
+  Самая внутренняя эмиссия помнит его простым указателем pos:
+  disconnect и перемещение подключения поправляют только его
+  (top_token), а в список эмиссия ничего не добавляет. Когда
+  начинается вложенная эмиссия, внешняя переходит на курсор -
+  собственный элемент списка сразу после позиции - и остаётся
+  на нём до конца (pos == nullptr).
+
+  Вложенные эмиссии, дошедшие до одной и той же позиции, разделяют
+  один курсор (группу), принадлежащий самой внешней из них.
+  Двигается всегда только самая внутренняя эмиссия, поэтому владелец
+  группы покидает её последним. Благодаря этому вложенная эмиссия
+  проходит мимо курсоров внешних за O(1) на каждый слот.
+
+  Если сигнал разрушается во время эмиссии, он обнуляет owner
+  у top_token и у всех групп в списке.
+  */
+  struct iteration_token : cursor {
+    using element = intrusive::list_element<struct connection_tag>;
+
+    explicit iteration_token(signal const *owner) noexcept
+        : limit(owner->next_serial), outer(owner->top_token) {
+      this->owner = owner;
+      if constexpr (deferred_teardown) {
+        home = owner->head;
+        ++home->refs;
+      }
+      if (outer != nullptr && outer->pos != nullptr) {
+        outer->park();
+      }
+      owner->top_token = this;
+      end = owner->list().front().prev;
+      pos = end;
+    }
+
+    iteration_token(iteration_token const &) = delete;
+    iteration_token &operator=(iteration_token const &) = delete;
+
     ~iteration_token() {
-      if (sig != nullptr) {
-        sig->top_token = next;
+      if (!destroyed()) {
+        this->owner->top_token = outer;
+      }
+      if constexpr (deferred_teardown) {
+        this->unlink();
+        control_block::release(home);
+      }
+    }
+
+    bool destroyed() const noexcept {
+      if constexpr (deferred_teardown) {
+        return !home->alive;
+      } else {
+        return group->owner == nullptr;
+      }
+    }
+
+    /* Стоит ли эмиссия сразу за conn, то есть не было ли conn отключено. */
+    bool follows(connection const *conn) const noexcept {
+      return (pos != nullptr ? pos : group->prev) == static_cast<node const *>(conn);
+    }
+
+    /*
+    Эмиссия пропускает курсоры, заблокированные подключения и
+    подключения, сделанные после её начала: connect_back и connect
+    с приоритетом могут поставить их за позицией.
+    */
+    bool skipped(element *e) const noexcept {
+      node *n = static_cast<node *>(e);
+      if (n->sig == nullptr) {
+        return true;
+      }
+      connection *conn = static_cast<connection *>(n);
+      return conn->stamp >= limit;
+    }
+
+    /* Остались ли незаблокированные подключения после позиции. */
+    bool at_end() const noexcept {
+      element *cur = (pos != nullptr ? pos : group)->next;
+      while (cur != end && skipped(cur)) {
+        cur = cur->next;
+      }
+      return cur == end;
+    }
+
+    /*
+    Переходит за следующее незаблокированное подключение, пропуская
+    курсоры, и возвращает это подключение. Если подключений
+    не осталось, nullptr.
+    */
+    connection *advance() noexcept {
+      if (pos == nullptr) {
+        return advance_cursor();
+      }
+      element *cur = pos->next;
+      while (cur != end && skipped(cur)) {
+        cur = cur->next;
+      }
+      if (cur == end) {
+        return nullptr;
+      }
+      pos = cur;
+      return static_cast<connection *>(static_cast<node *>(cur));
+    }
+
+    connection *advance_cursor() noexcept {
+      element *cur = group->next;
+      while (cur != end && skipped(cur)) {
+        cur = cur->next;
+      }
+      if (cur == end) {
+        return nullptr;
+      }
+
+      element *after = cur->next;
+      if (after != end && is_emission(static_cast<node *>(after))) {
+        this->unlink();
+        group = static_cast<iteration_token *>(static_cast<node *>(after));
+      } else if (group == this && this->next == cur) {
+        /* Частый случай: курсор просто меняется местами со слотом. */
+        this->prev->next = cur;
+        cur->prev = this->prev;
+        cur->next = this;
+        this->prev = cur;
+        this->next = after;
+        after->prev = this;
+      } else {
+        this->unlink();
+        this->prev = cur;
+        this->next = after;
+        after->prev = this;
+        cur->next = this;
+        group = this;
+      }
+
+      return static_cast<connection *>(static_cast<node *>(cur));
+    }
+
+    /* Переходит с pos на курсор: началась вложенная эмиссия. */
+    void park() noexcept {
+      element *after = pos->next;
+      if (after != end && is_emission(static_cast<node *>(after))) {
+        group = static_cast<iteration_token *>(static_cast<node *>(after));
+      } else {
+        this->prev = pos;
+        this->next = after;
+        after->prev = this;
+        pos->next = this;
+      }
+      pos = nullptr;
+    }
+
+    std::uint64_t limit;
+    element *pos = nullptr;
+    iteration_token *group = this;
+    iteration_token *outer;
+    element *end = nullptr;
+    control_block *home = nullptr;
+  };
+
+  /*
+  Инструментирование. Без него nesting_scope и slot_timer - пустые
+  структуры, а count_emit ничего не делает.
+  */
+  struct nesting_counter {
+    explicit nesting_counter(iteration_token const &tok) noexcept : tok(tok) {
+      signal_stats &counters = tok.owner->counters;
+      counters.max_depth = std::max(counters.max_depth, ++counters.depth);
+    }
+
+    nesting_counter(nesting_counter const &) = delete;
+    nesting_counter &operator=(nesting_counter const &) = delete;
+
+    ~nesting_counter() {
+      if (!tok.destroyed()) {
+        --tok.owner->counters.depth;
+      }
+    }
+
+    iteration_token const &tok;
+  };
+
+  /*
+  Замеряет вызов слота. Если слот отключил или переместил своё
+  подключение, время попадает только в общую гистограмму сигнала.
+  */
+  struct slot_time_recorder {
+    slot_time_recorder(connection *conn, iteration_token const &tok) noexcept
+        : conn(conn), tok(tok), start(std::chrono::steady_clock::now()) {}
+
+    slot_time_recorder(slot_time_recorder const &) = delete;
+    slot_time_recorder &operator=(slot_time_recorder const &) = delete;
+
+    ~slot_time_recorder() {
+      if (tok.destroyed()) {
+        return;
+      }
+      auto const elapsed =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+      tok.owner->counters.slot_latency.record(elapsed);
+      if (tok.follows(conn)) {
+        ++conn->stats.calls;
+        conn->stats.latency.record(elapsed);
+      }
+    }
+
+    connection *conn;
+    iteration_token const &tok;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  struct no_nesting_counter {
+    explicit no_nesting_counter(iteration_token const &) noexcept {}
+  };
+
+  struct no_slot_time_recorder {
+    no_slot_time_recorder(connection *, iteration_token const &) noexcept {}
+  };
+
+  using nesting_scope = std::conditional_t<instrumented, nesting_counter, no_nesting_counter>;
+  using slot_timer = std::conditional_t<instrumented, slot_time_recorder, no_slot_time_recorder>;
+
+  void count_emit() const noexcept {
+    if constexpr (instrumented) {
+      ++this->counters.emits;
+    }
+  }
+
+  /* Сигнал, которому принадлежит подключение, или nullptr, если он уже разрушен. */
+  static signal *live_signal(owner_t *owner) noexcept {
+    if constexpr (deferred_teardown) {
+      return owner->alive ? owner->target : nullptr;
+    } else {
+      return owner;
+    }
+  }
+
+  void collect_slots(std::vector<slot_stats> &out) const {
+    if constexpr (instrumented) {
+      for (node const &n : list()) {
+        if (n.sig != nullptr) {
+          out.push_back(static_cast<connection const &>(n).stats);
+        }
+      }
+    }
+  }
+
+  friend detail::signal_instrumentation<instrumented, signal>;
+
+  /* Исключения слотов при collect_exceptions: эмиссия продолжается, а они бросаются в конце. */
+  struct exception_collector {
+    template<typename F>
+    void run(F &&f) {
+      try {
+        f();
+      } catch (...) {
+        errors.push_back(std::current_exception());
+      }
+    }
+
+    void rethrow() {
+      if (!errors.empty()) {
+        throw emission_error(std::move(errors));
+      }
+    }
+
+    std::vector<std::exception_ptr> errors;
+  };
+
+  struct exception_passthrough {
+    template<typename F>
+    void run(F &&f) noexcept(noexcept_slots) {
+      f();
+    }
+
+    void rethrow() noexcept {}
+  };
+
+  using exception_sink = std::conditional_t<collect_exceptions, exception_collector, exception_passthrough>;
+
+  /*
+  Отключает исчерпавший вызовы слот connect_n перед последним вызовом
+  и возвращает его слот, который живёт до конца этого вызова.
+  */
+  static slot_t retire(connection *conn) noexcept {
+    slot_t last = conn->release_slot();
+    conn->disconnect();
+    return last;
+  }
+
+  /*
+  Вызывает слот conn. Аргументы, объявленные rvalue-ссылкой,
+  отдаются как rvalue, только если за conn нет других подключений.
+  */
+  static R call(connection *conn, iteration_token const &tok, detail::call_arg_t<Args>... args) noexcept(noexcept_slots) {
+    [[maybe_unused]] slot_timer timer(conn, tok);
+    if (conn->spend_call()) {
+      return invoke(retire(conn), tok, std::forward<detail::call_arg_t<Args>>(args)...);
+    }
+    return invoke(conn->slot, tok, std::forward<detail::call_arg_t<Args>>(args)...);
+  }
+
+  static R invoke(slot_t const &slot, iteration_token const &tok, detail::call_arg_t<Args>... args) noexcept(noexcept_slots) {
+    if constexpr (slot_t::movable_args) {
+      if (!tok.at_end()) {
+        return slot.call_shared(std::forward<detail::call_arg_t<Args>>(args)...);
+      }
+    }
+    return slot(std::forward<detail::call_arg_t<Args>>(args)...);
+  }
+
+  void emit(detail::call_arg_t<Args>... args) const noexcept(noexcept_slots) {
+    count_emit();
+    if (!active()) {
+      return;
+    }
+
+    iteration_token tok(this);
+    nesting_scope nesting(tok);
+    exception_sink errors;
+
+    while (connection *conn = tok.advance()) {
+      errors.run([&] { call(conn, tok, std::forward<detail::call_arg_t<Args>>(args)...); });
+
+      if (tok.destroyed()) {
+        break;
+      }
+    }
+    errors.rethrow();
+  }
+
+  /*
+  Эмиссия с комбинатором. Слот вызывается при первом разыменовании
+  итератора, указывающего на него, результат запоминается до перехода
+  к следующему слоту. Если сигнал разрушен во время вызова слота,
+  последовательность результатов на этом заканчивается.
+  */
+  struct invocation {
+    invocation(signal const *owner, detail::call_arg_t<Args>... args) noexcept
+        : tok(owner), nesting(tok), args(std::forward<detail::call_arg_t<Args>>(args)...), current(tok.advance()) {}
+
+    R const &get() {
+      if (!result) {
+        result.emplace(std::apply(
+            [this](auto &... args) { return call(current, tok, static_cast<detail::call_arg_t<Args>>(args)...); },
+            args));
       }
+      return *result;
+    }
+
+    void next() noexcept {
+      result.reset();
+      current = tok.destroyed() ? nullptr : tok.advance();
+    }
+
+    iteration_token tok;
+    nesting_scope nesting;
+    std::tuple<detail::call_arg_t<Args>...> args;
+    connection *current;
+    std::optional<R> result;
+  };
+
+ public:
+  /* Input-итератор по результатам слотов, который получает комбинатор. */
+  struct slot_iterator {
+    using iterator_category = std::input_iterator_tag;
+    using value_type = R;
+    using difference_type = std::ptrdiff_t;
+    using pointer = R const *;
+    using reference = R const &;
+
+    slot_iterator() noexcept = default;
+
+    reference operator*() const {
+      return inv->get();
+    }
+
+    pointer operator->() const {
+      return &inv->get();
+    }
+
+    slot_iterator &operator++() {
+      inv->next();
+      return *this;
+    }
+
+    /*
+    Значение, на которое указывал итератор до сдвига. Слот вызывается
+    сразу, потому что после next() его результат уже не хранится.
+    */
+    struct postfix_value {
+      R const &operator*() const noexcept {
+        return value;
+      }
+
+      R const *operator->() const noexcept {
+        return &value;
+      }
+
+      R value;
+    };
+
+    postfix_value operator++(int) {
+      postfix_value old{inv->get()};
+      inv->next();
+      return old;
     }
 
-    explicit iteration_token(signal const *sig) : current(sig->connections.begin()), next(sig->top_token), sig(sig) {
-      sig->top_token = this;
+    friend bool operator==(slot_iterator const &a, slot_iterator const &b) noexcept {
+      return a.at_end() == b.at_end();
     }
 
-    typename connection_t::const_iterator current;
-    iteration_token *next;
-    signal const *sig;
+    friend bool operator!=(slot_iterator const &a, slot_iterator const &b) noexcept {
+      return !(a == b);
+    }
+
+   private:
+    explicit slot_iterator(invocation *inv) noexcept : inv(inv) {}
+
+    bool at_end() const noexcept {
+      return inv == nullptr || inv->current == nullptr;
+    }
+
+    friend signal;
+
+    invocation *inv = nullptr;
   };
 
-  connection_t connections;
+ private:
+  /* Комбинатор копируется, потому что слот может разрушить сигнал. */
+  auto combine(detail::call_arg_t<Args>... args) const {
+    combiner_t comb = combiner;
+    count_emit();
+    if (!active()) {
+      return comb(slot_iterator(), slot_iterator());
+    }
+
+    invocation inv(this, std::forward<detail::call_arg_t<Args>>(args)...);
+    return comb(slot_iterator(&inv), slot_iterator());
+  }
+
+  template<typename F>
+  slot_t make_slot(F &&slot) const {
+    static_assert(!noexcept_slots || nothrow_slot<std::decay_t<F>>, "noexcept_slots requires noexcept slots");
+    if constexpr (slot_t::template accepts<F>) {
+      return slot_t(std::allocator_arg, get_allocator(), std::forward<F>(slot));
+    } else {
+      return slot_t(std::forward<F>(slot));
+    }
+  }
+
+  /* Готовый slot_t проверить нельзя, поэтому с noexcept_slots подключаются только сами функторы. */
+  template<typename F>
+  static constexpr bool nothrow_slot = !std::is_same_v<F, slot_t>
+      && std::is_nothrow_invocable_v<F &, detail::call_arg_t<Args>...>
+      && (!slot_t::movable_args || std::is_nothrow_invocable_v<F &, detail::shared_arg_t<Args>...>);
+
+  /* Эмиссия, стоящая на n, отступает на предыдущий элемент: n покидает список. */
+  void step_back(node &n) const noexcept {
+    if (top_token != nullptr && top_token->pos == &n) {
+      top_token->pos = n.prev;
+    }
+  }
+
+  /*
+  Удаляет группу приоритета, если conn - её последний слот: иначе
+  группы, в которых никого не осталось, копились бы в groups и в
+  списке. Между слотами группы могут стоять только курсоры эмиссий.
+  */
+  void leave_group(connection &conn) noexcept {
+    auto const end = list().end();
+    auto before = list().as_iterator(conn);
+    do {
+      --before;
+    } while (before != end && is_emission(&*before));
+    if (before == end || before->sig != nullptr || &*before == &back) {
+      return;
+    }
+
+    auto after = list().as_iterator(conn);
+    do {
+      ++after;
+    } while (after != end && is_emission(&*after));
+    if (after == end || after->sig == nullptr) {
+      step_back(*before);
+      groups.erase(static_cast<group_boundary &>(*before).priority);
+    }
+  }
+
+  /*
+  Граница между группами приоритетов и слотами connect_back.
+  Вставляется в список при первой необходимости.
+  */
+  node &back_boundary() noexcept {
+    if (!back.is_linked()) {
+      list().push_back(back);
+    }
+    return back;
+  }
+
+  static head_t make_head([[maybe_unused]] signal *target, allocator_type const &alloc) {
+    if constexpr (deferred_teardown) {
+      return control_block::make(target, alloc);
+    } else {
+      return head_t();
+    }
+  }
+
+  /* Число слотов и флаг block_all в старшем бите - в одном слове. */
+  std::size_t &counter() noexcept {
+    if constexpr (deferred_teardown) {
+      return head->count;
+    } else {
+      return count;
+    }
+  }
+
+  std::size_t counter() const noexcept {
+    if constexpr (deferred_teardown) {
+      return head->count;
+    } else {
+      return count;
+    }
+  }
+
+  connection_t &list() const noexcept {
+    if constexpr (deferred_teardown) {
+      return head->connections;
+    } else {
+      return head;
+    }
+  }
+
+  mutable head_t head;
   mutable iteration_token *top_token = nullptr;
+  std::size_t count = 0;
+  std::uint64_t next_serial = 0;
+  std::map<int, group_boundary, std::greater<>,
+           typename std::allocator_traits<allocator_type>::template rebind_alloc<std::pair<int const, group_boundary>>>
+      groups;
+  cursor back;
+  combiner_t combiner;
 };
-}
\ No newline at end of file
+
+namespace pmr {
+/* signal, который размещает слоты и служебные структуры в std::pmr::memory_resource. */
+template<typename Signature, typename... Options>
+using signal = signals::signal<Signature, slot_allocator<std::pmr::polymorphic_allocator<std::byte>>, Options...>;
+}
+}
@@ -0,0 +1,886 @@
+#include <benchmark/benchmark.h>
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "connection_group.h"
+#include "contiguous_signal.h"
+#include "executor.h"
+#include "hybrid_signal.h"
+#include "intrusive_list.h"
+#include "queued_connection.h"
+#include "signals.h"
+#include "slab_pool.h"
+#include "static_signal.h"
+#include "trackable.h"
+
+namespace {
+using signal_t = signals::signal<void(int)>;
+using connection_t = signal_t::connection;
+
+/* Лямбда, захватывающая N байт, чтобы не влезать в буфер std::function. */
+template<std::size_t N>
+struct capture {
+  std::array<char, N> payload{};
+  uint64_t *counter;
+
+  void operator()(int x) const {
+    *counter += x + payload[0];
+  }
+};
+
+std::vector<connection_t> connect_n(signal_t &sig, int64_t n, uint64_t &counter) {
+  std::vector<connection_t> conns;
+  conns.reserve(n);
+  for (int64_t i = 0; i < n; ++i) {
+    conns.push_back(sig.connect([&counter](int x) { counter += x; }));
+  }
+  return conns;
+}
+
+template<typename Function, std::size_t N>
+void function_construct(benchmark::State &state) {
+  uint64_t counter = 0;
+  for (auto _ : state) {
+    Function fn(capture<N>{{}, &counter});
+    benchmark::DoNotOptimize(fn);
+  }
+}
+
+template<typename Function, std::size_t N>
+void function_invoke(benchmark::State &state) {
+  uint64_t counter = 0;
+  Function fn(capture<N>{{}, &counter});
+  for (auto _ : state) {
+    fn(1);
+  }
+  benchmark::DoNotOptimize(counter);
+}
+
+template<std::size_t N>
+void signal_connect(benchmark::State &state) {
+  signal_t sig;
+  uint64_t counter = 0;
+  for (auto _ : state) {
+    auto conn = sig.connect(capture<N>{{}, &counter});
+    benchmark::DoNotOptimize(conn);
+  }
+}
+
+/* Подключение в одну из state.range(0) групп приоритетов. */
+void signal_connect_priority(benchmark::State &state) {
+  signal_t sig;
+  uint64_t counter = 0;
+  std::vector<connection_t> groups;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    groups.push_back(sig.connect(static_cast<int>(i), [&counter](int x) { counter += x; }));
+  }
+  int priority = 0;
+  for (auto _ : state) {
+    auto conn = sig.connect(priority, [&counter](int x) { counter += x; });
+    benchmark::DoNotOptimize(conn);
+    priority = (priority + 7) % static_cast<int>(state.range(0));
+  }
+}
+
+void signal_emit(benchmark::State &state) {
+  signal_t sig;
+  uint64_t counter = 0;
+  auto conns = connect_n(sig, state.range(0), counter);
+  for (auto _ : state) {
+    sig(1);
+  }
+  benchmark::DoNotOptimize(counter);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+struct handler {
+  void on_value(int x) {
+    total += x;
+  }
+
+  uint64_t total = 0;
+};
+
+uint64_t free_total = 0;
+
+void free_handler(int x) {
+  free_total += x;
+}
+
+/* Слоты-методы: лямбда с захватом объекта, делегат и указатель на функцию. */
+void emit_method_lambda(benchmark::State &state) {
+  signal_t sig;
+  std::vector<handler> handlers(state.range(0));
+  std::vector<connection_t> conns;
+  for (handler &h : handlers) {
+    conns.push_back(sig.connect([&h](int x) { h.on_value(x); }));
+  }
+  for (auto _ : state) {
+    sig(1);
+  }
+  benchmark::DoNotOptimize(handlers.data());
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void emit_method_delegate(benchmark::State &state) {
+  signal_t sig;
+  std::vector<handler> handlers(state.range(0));
+  std::vector<connection_t> conns;
+  for (handler &h : handlers) {
+    conns.push_back(sig.connect<&handler::on_value>(&h));
+  }
+  for (auto _ : state) {
+    sig(1);
+  }
+  benchmark::DoNotOptimize(handlers.data());
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void emit_function_pointer(benchmark::State &state) {
+  signal_t sig;
+  std::vector<connection_t> conns;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    conns.push_back(sig.connect(&free_handler));
+  }
+  for (auto _ : state) {
+    sig(1);
+  }
+  benchmark::DoNotOptimize(free_total);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void emit_function_delegate(benchmark::State &state) {
+  signal_t sig;
+  std::vector<connection_t> conns;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    conns.push_back(sig.connect<&free_handler>());
+  }
+  for (auto _ : state) {
+    sig(1);
+  }
+  benchmark::DoNotOptimize(free_total);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+uint64_t static_total = 0;
+
+void static_handler(int x) {
+  static_total += x;
+}
+
+/* Десять одинаковых обработчиков: в signal и в static_signal. */
+void emit_dynamic_fixed(benchmark::State &state) {
+  signal_t sig;
+  std::vector<connection_t> conns;
+  for (int i = 0; i < 10; ++i) {
+    conns.push_back(sig.connect<&static_handler>());
+  }
+  for (auto _ : state) {
+    sig(1);
+  }
+  benchmark::DoNotOptimize(static_total);
+}
+
+void emit_static_fixed(benchmark::State &state) {
+  signals::static_signal<void(int), &static_handler, &static_handler, &static_handler, &static_handler,
+                         &static_handler, &static_handler, &static_handler, &static_handler, &static_handler,
+                         &static_handler> sig;
+  for (auto _ : state) {
+    sig(1);
+    benchmark::ClobberMemory();
+  }
+  benchmark::DoNotOptimize(static_total);
+}
+
+/* Те же десять обработчиков в hybrid_signal; state.range(0) - число динамических слотов. */
+void emit_hybrid_fixed(benchmark::State &state) {
+  signals::hybrid_signal<void(int), &static_handler, &static_handler, &static_handler, &static_handler,
+                         &static_handler, &static_handler, &static_handler, &static_handler, &static_handler,
+                         &static_handler> sig;
+  std::vector<connection_t> conns;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    conns.push_back(sig.connect<&static_handler>());
+  }
+  for (auto _ : state) {
+    sig(1);
+    benchmark::ClobberMemory();
+  }
+  benchmark::DoNotOptimize(static_total);
+}
+
+/* Дорогие аргументы: строка собирается при каждой эмиссии или только при наличии слотов. */
+void emit_formatted(benchmark::State &state) {
+  signals::signal<void(std::string const &)> sig;
+  uint64_t counter = 0;
+  std::vector<signals::signal<void(std::string const &)>::connection> conns;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    conns.push_back(sig.connect([&counter](std::string const &s) { counter += s.size(); }));
+  }
+  int value = 0;
+  for (auto _ : state) {
+    sig("value: " + std::to_string(++value) + " of many, formatted eagerly");
+  }
+  benchmark::DoNotOptimize(counter);
+}
+
+void emit_lazy_formatted(benchmark::State &state) {
+  signals::signal<void(std::string const &)> sig;
+  uint64_t counter = 0;
+  std::vector<signals::signal<void(std::string const &)>::connection> conns;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    conns.push_back(sig.connect([&counter](std::string const &s) { counter += s.size(); }));
+  }
+  int value = 0;
+  for (auto _ : state) {
+    sig.emit_lazy([&] { return "value: " + std::to_string(++value) + " of many, formatted eagerly"; });
+  }
+  benchmark::DoNotOptimize(counter);
+}
+
+/* Эмиссия при каждой из политик исключений; слоты не бросают. */
+template<typename Policy>
+void emit_exception_policy(benchmark::State &state) {
+  signals::signal<void(int), Policy> sig;
+  uint64_t counter = 0;
+  std::vector<typename decltype(sig)::connection> conns;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    conns.push_back(sig.connect([&counter](int x) noexcept { counter += x; }));
+  }
+  for (auto _ : state) {
+    sig(1);
+  }
+  benchmark::DoNotOptimize(counter);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/* Слоты объектов, переживших бы сигнал: shared_ptr + lock в каждом вызове или trackable. */
+struct tracked_handler : signals::trackable {
+  void on_value(int x) {
+    total += x;
+  }
+
+  uint64_t total = 0;
+};
+
+void emit_weak_lock(benchmark::State &state) {
+  signal_t sig;
+  std::vector<std::shared_ptr<tracked_handler>> handlers;
+  std::vector<connection_t> conns;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    handlers.push_back(std::make_shared<tracked_handler>());
+    conns.push_back(sig.connect([weak = std::weak_ptr<tracked_handler>(handlers.back())](int x) {
+      if (auto h = weak.lock()) {
+        h->on_value(x);
+      }
+    }));
+  }
+  for (auto _ : state) {
+    sig(1);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void emit_tracked(benchmark::State &state) {
+  signal_t sig;
+  std::vector<std::unique_ptr<tracked_handler>> handlers;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    handlers.push_back(std::make_unique<tracked_handler>());
+    signals::connect_tracked<&tracked_handler::on_value>(sig, *handlers.back());
+  }
+  for (auto _ : state) {
+    sig(1);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/*
+Одноразовый слот: connect_once и эмиссия, которая его отключает, против
+connect, эмиссии и ручного disconnect. range(0) - число постоянных слотов.
+*/
+void emit_once(benchmark::State &state) {
+  signal_t sig;
+  uint64_t counter = 0;
+  std::vector<connection_t> conns;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    conns.push_back(sig.connect([&counter](int x) { counter += x; }));
+  }
+  for (auto _ : state) {
+    connection_t once = sig.connect_once([&counter](int x) { counter += x; });
+    sig(1);
+  }
+  benchmark::DoNotOptimize(counter);
+}
+
+void emit_manual_disconnect(benchmark::State &state) {
+  signal_t sig;
+  uint64_t counter = 0;
+  std::vector<connection_t> conns;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    conns.push_back(sig.connect([&counter](int x) { counter += x; }));
+  }
+  for (auto _ : state) {
+    connection_t once = sig.connect([&counter](int x) { counter += x; });
+    sig(1);
+    once.disconnect();
+  }
+  benchmark::DoNotOptimize(counter);
+}
+
+/*
+Временное отключение одного из range(0) слотов на время эмиссии:
+block/unblock против disconnect и повторного connect.
+*/
+void pause_block(benchmark::State &state) {
+  signal_t sig;
+  uint64_t counter = 0;
+  std::vector<connection_t> conns;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    conns.push_back(sig.connect([&counter](int x) { counter += x; }));
+  }
+  for (auto _ : state) {
+    conns.front().block();
+    sig(1);
+    conns.front().unblock();
+  }
+  benchmark::DoNotOptimize(counter);
+}
+
+void pause_reconnect(benchmark::State &state) {
+  signal_t sig;
+  uint64_t counter = 0;
+  std::vector<connection_t> conns;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    conns.push_back(sig.connect([&counter](int x) { counter += x; }));
+  }
+  for (auto _ : state) {
+    conns.front().disconnect();
+    sig(1);
+    conns.front() = sig.connect([&counter](int x) { counter += x; });
+  }
+  benchmark::DoNotOptimize(counter);
+}
+
+/* Эмиссия сигнала с range(0) слотами после block_all. */
+void emit_blocked_all(benchmark::State &state) {
+  signal_t sig;
+  uint64_t counter = 0;
+  std::vector<connection_t> conns;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    conns.push_back(sig.connect([&counter](int x) { counter += x; }));
+  }
+  sig.block_all();
+  for (auto _ : state) {
+    sig(1);
+  }
+  benchmark::DoNotOptimize(counter);
+}
+
+/*
+Эмиссия с явно выключенным и включённым инструментированием.
+С no_instrumentation результат должен совпадать с signal_emit.
+*/
+template<typename Instrumentation>
+void emit_instrumented(benchmark::State &state) {
+  signals::signal<void(int), Instrumentation> sig;
+  uint64_t counter = 0;
+  std::vector<typename decltype(sig)::connection> conns;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    conns.push_back(sig.connect([&counter](int x) { counter += x; }));
+  }
+  for (auto _ : state) {
+    sig(1);
+  }
+  benchmark::DoNotOptimize(counter);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template<typename Instrumentation>
+void connect_disconnect_instrumented(benchmark::State &state) {
+  signals::signal<void(int), Instrumentation> sig;
+  uint64_t counter = 0;
+  for (auto _ : state) {
+    auto conn = sig.connect([&counter](int x) { counter += x; });
+    benchmark::DoNotOptimize(conn);
+  }
+  benchmark::DoNotOptimize(counter);
+}
+
+/*
+Подключения разбросаны по куче вперемешку с посторонними аллокациями,
+как это бывает, когда их хранят объекты-подписчики.
+*/
+template<typename Signal>
+void emit_scattered(benchmark::State &state) {
+  Signal sig;
+  uint64_t counter = 0;
+  std::vector<std::unique_ptr<typename Signal::connection>> conns;
+  std::vector<std::unique_ptr<std::array<char, 200>>> noise;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    conns.push_back(std::make_unique<typename Signal::connection>(sig.connect([&counter](int x) { counter += x; })));
+    noise.push_back(std::make_unique<std::array<char, 200>>());
+  }
+  for (auto _ : state) {
+    sig(1);
+  }
+  benchmark::DoNotOptimize(counter);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/* 1000 слотов, равномерно разложенных по state.range(0) группам. */
+void signal_emit_grouped(benchmark::State &state) {
+  signal_t sig;
+  uint64_t counter = 0;
+  std::vector<connection_t> conns;
+  for (int i = 0; i < 1000; ++i) {
+    conns.push_back(sig.connect(i % static_cast<int>(state.range(0)), [&counter](int x) { counter += x; }));
+  }
+  for (auto _ : state) {
+    sig(1);
+  }
+  benchmark::DoNotOptimize(counter);
+  state.SetItemsProcessed(state.iterations() * 1000);
+}
+
+void emit_loop(benchmark::State &state) {
+  signal_t sig;
+  uint64_t counter = 0;
+  auto conns = connect_n(sig, state.range(0), counter);
+  std::vector<std::tuple<int>> payloads(state.range(1), std::tuple<int>(1));
+  for (auto _ : state) {
+    for (auto const &payload : payloads) {
+      sig(std::get<0>(payload));
+    }
+  }
+  benchmark::DoNotOptimize(counter);
+  state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(1));
+}
+
+void emit_batch(benchmark::State &state) {
+  signal_t sig;
+  uint64_t counter = 0;
+  auto conns = connect_n(sig, state.range(0), counter);
+  std::vector<std::tuple<int>> payloads(state.range(1), std::tuple<int>(1));
+  for (auto _ : state) {
+    sig.emit_batch(payloads);
+  }
+  benchmark::DoNotOptimize(counter);
+  state.SetItemsProcessed(state.iterations() * state.range(0) * state.range(1));
+}
+
+/*
+Тяжёлый аргумент, объявленный по значению. Для сравнения - прежняя
+схема: копия на входе в эмиссию и ещё одна на каждый слот.
+*/
+void emit_heavy_payload_by_value_copies(benchmark::State &state) {
+  std::vector<std::function<void(std::string)>> slots;
+  std::size_t total = 0;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    slots.emplace_back([&total](std::string s) { total += s.size(); });
+  }
+  std::string const payload(1024, 'x');
+  for (auto _ : state) {
+    std::string arg = payload;
+    for (auto const &slot : slots) {
+      slot(arg);
+    }
+  }
+  benchmark::DoNotOptimize(total);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void emit_heavy_payload(benchmark::State &state) {
+  signals::signal<void(std::string)> sig;
+  std::size_t total = 0;
+  std::vector<signals::signal<void(std::string)>::connection> conns;
+  for (int64_t i = 0; i < state.range(0); ++i) {
+    conns.push_back(sig.connect([&total](std::string const &s) { total += s.size(); }));
+  }
+  std::string const payload(1024, 'x');
+  for (auto _ : state) {
+    sig(payload);
+  }
+  benchmark::DoNotOptimize(total);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/* Сигнал с rvalue-аргументом: последний слот забирает вектор себе. */
+void emit_heavy_payload_move_last(benchmark::State &state) {
+  signals::signal<void(std::vector<int> &&)> sig;
+  std::size_t total = 0;
+  std::vector<int> sink;
+  std::vector<signals::signal<void(std::vector<int> &&)>::connection> conns;
+  conns.push_back(sig.connect([&sink](std::vector<int> &&v) { sink = std::move(v); }));
+  for (int64_t i = 1; i < state.range(0); ++i) {
+    conns.push_back(sig.connect([&total](std::vector<int> const &v) { total += v.size(); }));
+  }
+  for (auto _ : state) {
+    sig(std::vector<int>(256, 1));
+  }
+  benchmark::DoNotOptimize(total);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/* Эмиссия в отложенное подключение и доставка через event_loop. */
+void emit_queued(benchmark::State &state) {
+  signal_t sig;
+  signals::event_loop loop;
+  uint64_t counter = 0;
+  auto conn = signals::connect_queued(sig, loop, [&counter](int x) { counter += x; });
+  for (auto _ : state) {
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      sig(1);
+    }
+    loop.poll();
+  }
+  benchmark::DoNotOptimize(counter);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void signal_emit_recursive(benchmark::State &state) {
+  signal_t sig;
+  uint64_t counter = 0;
+  auto conn = sig.connect([&](int depth) {
+    ++counter;
+    if (depth > 0) {
+      sig(depth - 1);
+    }
+  });
+  for (auto _ : state) {
+    sig(static_cast<int>(state.range(0)) - 1);
+  }
+  benchmark::DoNotOptimize(counter);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/* Каждый слот при вызове отключает соседа и подключает его заново. */
+void signal_disconnect_in_emit(benchmark::State &state) {
+  signal_t sig;
+  uint64_t counter = 0;
+  std::vector<connection_t> conns(state.range(0));
+  std::function<void(std::size_t)> reconnect = [&](std::size_t i) {
+    conns[i] = sig.connect([&, i](int x) {
+      counter += x;
+      std::size_t victim = (i + 1) % conns.size();
+      conns[victim].disconnect();
+      reconnect(victim);
+    });
+  };
+  for (std::size_t i = 0; i < conns.size(); ++i) {
+    reconnect(i);
+  }
+  for (auto _ : state) {
+    sig(1);
+  }
+  benchmark::DoNotOptimize(counter);
+}
+
+/* disconnect и перемещение изнутри эмиссии на глубине state.range(0). */
+void signal_disconnect_nested(benchmark::State &state) {
+  signal_t sig;
+  uint64_t counter = 0;
+  connection_t victim;
+  auto conn = sig.connect([&](int depth) {
+    if (depth > 0) {
+      sig(depth - 1);
+      return;
+    }
+    for (auto _ : state) {
+      victim = sig.connect([&counter](int x) { counter += x; });
+      victim.disconnect();
+    }
+  });
+  sig(static_cast<int>(state.range(0)) - 1);
+}
+
+void signal_move_nested(benchmark::State &state) {
+  signal_t sig;
+  uint64_t counter = 0;
+  connection_t first = sig.connect([&counter](int x) { counter += x; });
+  connection_t second;
+  auto conn = sig.connect([&](int depth) {
+    if (depth > 0) {
+      sig(depth - 1);
+      return;
+    }
+    for (auto _ : state) {
+      second = std::move(first);
+      first = std::move(second);
+    }
+  });
+  sig(static_cast<int>(state.range(0)) - 1);
+}
+
+void connection_move(benchmark::State &state) {
+  signal_t sig;
+  uint64_t counter = 0;
+  auto conns = connect_n(sig, state.range(0), counter);
+  std::vector<connection_t> other(conns.size());
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < conns.size(); ++i) {
+      other[i] = std::move(conns[i]);
+    }
+    std::swap(conns, other);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void connection_connect_disconnect(benchmark::State &state) {
+  signal_t sig;
+  uint64_t counter = 0;
+  auto conns = connect_n(sig, state.range(0), counter);
+  for (auto _ : state) {
+    connection_t conn = sig.connect([&counter](int x) { counter += x; });
+    conn.disconnect();
+  }
+}
+
+/* Подключение и отключение слота, не помещающегося во встроенный буфер. */
+void connection_churn_large(benchmark::State &state) {
+  signal_t sig;
+  uint64_t counter = 0;
+  for (auto _ : state) {
+    connection_t conn = sig.connect(capture<64>{{}, &counter});
+    benchmark::DoNotOptimize(conn);
+  }
+}
+
+void connection_churn_large_pmr(benchmark::State &state) {
+  signals::slab_pool pool;
+  signals::pmr::signal<void(int)> sig(&pool);
+  uint64_t counter = 0;
+  for (auto _ : state) {
+    auto conn = sig.connect(capture<64>{{}, &counter});
+    benchmark::DoNotOptimize(conn);
+  }
+}
+
+/* Разрушение сигнала с state.range(0) подключениями. */
+template<typename Teardown>
+void signal_teardown(benchmark::State &state) {
+  using signal = signals::signal<void(int), Teardown>;
+  uint64_t counter = 0;
+  std::vector<typename signal::connection> conns;
+  conns.reserve(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto sig = std::make_unique<signal>();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      conns.push_back(sig->connect(capture<24>{{}, &counter}));
+    }
+    state.ResumeTiming();
+    sig.reset();
+    state.PauseTiming();
+    conns.clear();
+    state.ResumeTiming();
+  }
+}
+
+/* Подписчик с state.range(0) подключениями к 8 сигналам отписывается от всех. */
+void subscriber_teardown(benchmark::State &state) {
+  std::array<signal_t, 8> sigs;
+  uint64_t counter = 0;
+  std::vector<connection_t> conns;
+  conns.reserve(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      conns.push_back(sigs[i % sigs.size()].connect([&counter](int x) { counter += x; }));
+    }
+    state.ResumeTiming();
+    conns.clear();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void subscriber_teardown_group(benchmark::State &state) {
+  std::array<signal_t, 8> sigs;
+  uint64_t counter = 0;
+  signals::connection_group group;
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      group.add(sigs[i % sigs.size()].connect([&counter](int x) { counter += x; }));
+    }
+    state.ResumeTiming();
+    group.disconnect_all();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+struct node : intrusive::list_element<> {};
+
+void list_push_erase(benchmark::State &state) {
+  std::vector<node> nodes(state.range(0));
+  intrusive::list<node> list;
+  for (auto _ : state) {
+    for (auto &n : nodes) {
+      list.push_back(n);
+    }
+    while (!list.empty()) {
+      list.erase(list.begin());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/* То же со счётчиком размера: каждая вставка и удаление обновляют size(). */
+struct sized_node : intrusive::list_element<intrusive::default_tag, intrusive::tracked_size> {};
+
+void list_push_erase_tracked_size(benchmark::State &state) {
+  std::vector<sized_node> nodes(state.range(0));
+  intrusive::list<sized_node, intrusive::default_tag, intrusive::tracked_size> list;
+  for (auto _ : state) {
+    for (auto &n : nodes) {
+      list.push_back(n);
+    }
+    benchmark::DoNotOptimize(list.size());
+    while (!list.empty()) {
+      list.erase(list.begin());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void list_splice(benchmark::State &state) {
+  std::vector<node> nodes(state.range(0));
+  intrusive::list<node> from;
+  intrusive::list<node> to;
+  for (auto &n : nodes) {
+    from.push_back(n);
+  }
+  for (auto _ : state) {
+    to.splice(to.end(), from, from.begin(), from.end());
+    from.splice(from.end(), to, to.begin(), to.end());
+  }
+}
+
+/* Перенос всего списка: splice(pos, list&) против поэлементного переноса. */
+void list_splice_all(benchmark::State &state) {
+  std::vector<node> nodes(state.range(0));
+  intrusive::list<node> from;
+  intrusive::list<node> to;
+  for (auto &n : nodes) {
+    from.push_back(n);
+  }
+  for (auto _ : state) {
+    to.splice(to.end(), from);
+    from.splice(from.end(), to);
+  }
+}
+
+void list_move_elementwise(benchmark::State &state) {
+  std::vector<node> nodes(state.range(0));
+  intrusive::list<node> from;
+  intrusive::list<node> to;
+  for (auto &n : nodes) {
+    from.push_back(n);
+  }
+  for (auto _ : state) {
+    while (!from.empty()) {
+      node &n = from.front();
+      from.pop_front();
+      to.push_back(n);
+    }
+    std::swap(from, to);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/*
+Заполнение и очистка списка: clear против clear_unsafe_detach.
+После clear_unsafe_detach элементы остаются в кольце, поэтому
+перед вставкой каждый отвязывается.
+*/
+template<bool Detach>
+void list_clear(benchmark::State &state) {
+  std::vector<node> nodes(state.range(0));
+  intrusive::list<node> list;
+  for (auto _ : state) {
+    for (auto &n : nodes) {
+      if constexpr (Detach) {
+        n.unlink();
+      }
+      list.push_back(n);
+    }
+    if constexpr (Detach) {
+      list.clear_unsafe_detach();
+    } else {
+      list.clear();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+}
+
+BENCHMARK_TEMPLATE(function_construct, std::function<void(int)>, 8);
+BENCHMARK_TEMPLATE(function_construct, std::function<void(int)>, 24);
+BENCHMARK_TEMPLATE(function_construct, signals::small_function<void(int)>, 8);
+BENCHMARK_TEMPLATE(function_construct, signals::small_function<void(int)>, 24);
+
+BENCHMARK_TEMPLATE(function_invoke, std::function<void(int)>, 8);
+BENCHMARK_TEMPLATE(function_invoke, std::function<void(int)>, 24);
+BENCHMARK_TEMPLATE(function_invoke, signals::small_function<void(int)>, 8);
+BENCHMARK_TEMPLATE(function_invoke, signals::small_function<void(int)>, 24);
+
+BENCHMARK_TEMPLATE(signal_connect, 8);
+BENCHMARK_TEMPLATE(signal_connect, 24);
+
+BENCHMARK(signal_connect_priority)->Arg(1)->Arg(16)->Arg(1024);
+BENCHMARK(signal_emit)->Arg(0)->Arg(1)->Arg(10)->Arg(1000);
+BENCHMARK(emit_method_lambda)->Arg(1)->Arg(1000);
+BENCHMARK(emit_method_delegate)->Arg(1)->Arg(1000);
+BENCHMARK(emit_function_pointer)->Arg(1)->Arg(1000);
+BENCHMARK(emit_function_delegate)->Arg(1)->Arg(1000);
+BENCHMARK_TEMPLATE(emit_exception_policy, signals::propagate_exceptions)->Arg(1)->Arg(10)->Arg(1000);
+BENCHMARK_TEMPLATE(emit_exception_policy, signals::collect_exceptions)->Arg(1)->Arg(10)->Arg(1000);
+BENCHMARK_TEMPLATE(emit_exception_policy, signals::noexcept_slots)->Arg(1)->Arg(10)->Arg(1000);
+BENCHMARK(pause_block)->Arg(1)->Arg(10);
+BENCHMARK(pause_reconnect)->Arg(1)->Arg(10);
+BENCHMARK(emit_blocked_all)->Arg(1)->Arg(1000);
+BENCHMARK(emit_once)->Arg(0)->Arg(10);
+BENCHMARK(emit_manual_disconnect)->Arg(0)->Arg(10);
+BENCHMARK(emit_weak_lock)->Arg(1)->Arg(100);
+BENCHMARK(emit_tracked)->Arg(1)->Arg(100);
+BENCHMARK(emit_formatted)->Arg(0)->Arg(1);
+BENCHMARK(emit_lazy_formatted)->Arg(0)->Arg(1);
+BENCHMARK(emit_dynamic_fixed);
+BENCHMARK(emit_static_fixed);
+BENCHMARK(emit_hybrid_fixed)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(emit_instrumented, signals::no_instrumentation)->Arg(0)->Arg(1)->Arg(10)->Arg(1000);
+BENCHMARK_TEMPLATE(emit_instrumented, signals::stats_instrumentation)->Arg(0)->Arg(1)->Arg(10)->Arg(1000);
+BENCHMARK_TEMPLATE(connect_disconnect_instrumented, signals::no_instrumentation);
+BENCHMARK_TEMPLATE(connect_disconnect_instrumented, signals::stats_instrumentation);
+BENCHMARK_TEMPLATE(emit_scattered, signal_t)->Arg(10)->Arg(1000)->Arg(100000);
+BENCHMARK_TEMPLATE(emit_scattered, signals::contiguous_signal<void(int)>)->Arg(10)->Arg(1000)->Arg(100000);
+BENCHMARK(signal_emit_grouped)->Arg(1)->Arg(10)->Arg(100);
+BENCHMARK(emit_loop)->ArgsProduct({{1, 10, 1000}, {16, 1024}});
+BENCHMARK(emit_batch)->ArgsProduct({{1, 10, 1000}, {16, 1024}});
+BENCHMARK(emit_heavy_payload_by_value_copies)->Arg(1)->Arg(10);
+BENCHMARK(emit_heavy_payload)->Arg(1)->Arg(10);
+BENCHMARK(emit_heavy_payload_move_last)->Arg(1)->Arg(10);
+BENCHMARK(emit_queued)->Arg(1)->Arg(64);
+BENCHMARK(signal_emit_recursive)->Arg(1)->Arg(10)->Arg(100);
+BENCHMARK(signal_disconnect_in_emit)->Arg(2)->Arg(10)->Arg(1000);
+BENCHMARK(signal_disconnect_nested)->RangeMultiplier(10)->Range(1, 1000);
+BENCHMARK(signal_move_nested)->RangeMultiplier(10)->Range(1, 1000);
+BENCHMARK(connection_move)->Arg(1)->Arg(1000);
+BENCHMARK(connection_connect_disconnect)->Arg(0)->Arg(1000);
+BENCHMARK_TEMPLATE(signal_teardown, signals::eager_teardown)->Arg(1000)->Arg(100000);
+BENCHMARK_TEMPLATE(signal_teardown, signals::deferred_teardown)->Arg(1000)->Arg(100000);
+BENCHMARK(subscriber_teardown)->Arg(100)->Arg(10000);
+BENCHMARK(subscriber_teardown_group)->Arg(100)->Arg(10000);
+BENCHMARK(connection_churn_large);
+BENCHMARK(connection_churn_large_pmr);
+
+BENCHMARK(list_push_erase)->Arg(1)->Arg(1000);
+BENCHMARK(list_push_erase_tracked_size)->Arg(1)->Arg(1000);
+BENCHMARK(list_splice)->Arg(1)->Arg(1000);
+BENCHMARK(list_splice_all)->Arg(1)->Arg(1000);
+BENCHMARK(list_move_elementwise)->Arg(1)->Arg(1000);
+BENCHMARK_TEMPLATE(list_clear, false)->Arg(1000)->Arg(100000);
+BENCHMARK_TEMPLATE(list_clear, true)->Arg(1000)->Arg(100000);
+
+BENCHMARK_MAIN();
@@ -1,5 +1,46 @@
 #include <gtest/gtest.h>
+#include <array>
+#include <coroutine>
+#include <cstdlib>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "combiners.h"
+#include "connection_group.h"
+#include "contiguous_signal.h"
+#include "executor.h"
+#include "hybrid_signal.h"
+#include "intrusive_list.h"
 #include "signals.h"
+#include "slab_pool.h"
+#include "small_vector.h"
+#include "static_signal.h"
+#include "trackable.h"
+
+/* Счётчик обращений к глобальному operator new для тестов аллокаций. */
+static std::size_t global_allocations = 0;
+
+void* operator new(std::size_t size)
+{
+    ++global_allocations;
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
 
 TEST(signal_testing, trivial)
 {
@@ -11,13 +52,13 @@ TEST(signal_testing, trivial)
 
     sig();
 
-    EXPECT_EQ(1, got1);
-    EXPECT_EQ(1, got2);
+    EXPECT_EQ(1u, got1);
+    EXPECT_EQ(1u, got2);
 
     sig();
 
-    EXPECT_EQ(2, got1);
-    EXPECT_EQ(2, got2);
+    EXPECT_EQ(2u, got1);
+    EXPECT_EQ(2u, got2);
 }
 
 TEST(signal_testing, arguments)
@@ -50,14 +91,14 @@ TEST(signal_testing, disconnect)
 
     sig();
 
-    EXPECT_EQ(1, got1);
-    EXPECT_EQ(1, got2);
+    EXPECT_EQ(1u, got1);
+    EXPECT_EQ(1u, got2);
 
     conn1.disconnect();
     sig();
 
-    EXPECT_EQ(1, got1);
-    EXPECT_EQ(2, got2);
+    EXPECT_EQ(1u, got1);
+    EXPECT_EQ(2u, got2);
 }
 
 TEST(signal_testing, connection_move_ctor)
@@ -69,7 +110,7 @@ TEST(signal_testing, connection_move_ctor)
 
     sig();
 
-    EXPECT_EQ(1, got1);
+    EXPECT_EQ(1u, got1);
 }
 
 TEST(signal_testing, connection_destructor)
@@ -82,14 +123,14 @@ TEST(signal_testing, connection_destructor)
 
     sig();
 
-    EXPECT_EQ(1, got1);
-    EXPECT_EQ(1, got2);
+    EXPECT_EQ(1u, got1);
+    EXPECT_EQ(1u, got2);
 
     conn1.reset();
     sig();
 
-    EXPECT_EQ(1, got1);
-    EXPECT_EQ(2, got2);
+    EXPECT_EQ(1u, got1);
+    EXPECT_EQ(2u, got2);
 }
 
 TEST(signal_testing, disconnect_in_emit)
@@ -106,15 +147,35 @@ TEST(signal_testing, disconnect_in_emit)
 
     sig();
 
-    EXPECT_EQ(1, got1);
-    EXPECT_EQ(1, got2);
-    EXPECT_EQ(1, got3);
+    EXPECT_EQ(1u, got1);
+    EXPECT_EQ(1u, got2);
+    EXPECT_EQ(1u, got3);
+
+    sig();
+
+    EXPECT_EQ(2u, got1);
+    EXPECT_EQ(1u, got2);
+    EXPECT_EQ(2u, got3);
+}
+
+TEST(signal_testing, disconnect_next_in_emit)
+{
+    using connection = signals::signal<void()>::connection;
+    signals::signal<void()> sig;
+    uint32_t got1 = 0;
+    connection conn1 = sig.connect([&] { ++got1; });
+    uint32_t got2 = 0;
+    connection conn2 = sig.connect([&] { ++got2; conn1.disconnect(); conn1 = sig.connect([&] { ++got1; }); });
+
+    sig();
+
+    EXPECT_EQ(0u, got1);
+    EXPECT_EQ(1u, got2);
 
     sig();
 
-    EXPECT_EQ(2, got1);
-    EXPECT_EQ(1, got2);
-    EXPECT_EQ(2, got3);
+    EXPECT_EQ(1u, got1);
+    EXPECT_EQ(2u, got2);
 }
 
 TEST(signal_testing, destroy_signal_before_connection_01)
@@ -151,7 +212,7 @@ TEST(signal_testing, destroy_signal_in_emit)
 
     (*sig)();
 
-    EXPECT_EQ(1, got2);
+    EXPECT_EQ(1u, got2);
 }
 
 TEST(signal_testing, recursive_emit)
@@ -175,7 +236,70 @@ TEST(signal_testing, recursive_emit)
 
     (*sig)();
 
-    EXPECT_EQ(2, got2);
+    EXPECT_EQ(2u, got2);
+}
+
+TEST(signal_testing, disconnect_in_recursive_emit)
+{
+    using connection = signals::signal<void(int)>::connection;
+    signals::signal<void(int)> sig;
+    uint32_t got1 = 0;
+    connection conn1 = sig.connect([&](int) { ++got1; });
+    uint32_t got2 = 0;
+    connection conn2 = sig.connect([&](int depth)
+    {
+        ++got2;
+        if (depth > 0)
+            sig(depth - 1);
+        else
+            conn1.disconnect();
+    });
+
+    sig(3);
+
+    EXPECT_EQ(0u, got1);
+    EXPECT_EQ(4u, got2);
+}
+
+TEST(signal_testing, disconnect_after_nested_emit)
+{
+    using connection = signals::signal<void(int)>::connection;
+    signals::signal<void(int)> sig;
+    std::vector<int> order;
+    connection conn2;
+    connection conn1 = sig.connect_back([&](int depth)
+    {
+        order.push_back(depth);
+        if (depth > 0)
+            sig(depth - 1);
+        conn2.disconnect();
+    });
+    conn2 = sig.connect_back([&](int depth) { order.push_back(depth * 10); });
+    connection conn3 = sig.connect_back([&](int depth) { order.push_back(depth * 100); });
+
+    sig(1);
+
+    EXPECT_EQ((std::vector<int>{1, 0, 0, 100}), order);
+}
+
+TEST(signal_testing, move_in_recursive_emit)
+{
+    using connection = signals::signal<void(int)>::connection;
+    signals::signal<void(int)> sig;
+    uint32_t got1 = 0;
+    connection conn1_old = sig.connect([&](int) { ++got1; });
+    connection conn1_new;
+    connection conn2 = sig.connect([&](int depth)
+    {
+        if (depth > 0)
+            sig(depth - 1);
+        else
+            conn1_new = std::move(conn1_old);
+    });
+
+    sig(3);
+
+    EXPECT_EQ(4u, got1);
 }
 
 TEST(signal_testing, exception_in_emit)
@@ -199,16 +323,16 @@ TEST(signal_testing, exception_in_emit)
     auto conn3 = sig->connect([&] { ++got3; });
 
     EXPECT_THROW((*sig)(), test_exception);
-    EXPECT_EQ(2, got2);
+    EXPECT_EQ(2u, got2);
 
     got1 = 0;
     got3 = 0;
 
     (*sig)();
 
-    EXPECT_EQ(1, got1);
-    EXPECT_EQ(3, got2);
-    EXPECT_EQ(1, got3);
+    EXPECT_EQ(1u, got1);
+    EXPECT_EQ(3u, got2);
+    EXPECT_EQ(1u, got3);
 }
 
 TEST(signal_testing, move_in_emit_01)
@@ -231,10 +355,102 @@ TEST(signal_testing, move_in_emit_01)
     });
 
     sig();
-    EXPECT_EQ(1, got1);
+    EXPECT_EQ(1u, got1);
+
+    sig();
+    EXPECT_EQ(2u, got1);
+}
+
+TEST(signal_testing, move_in_emit_shared_capture)
+{
+    using connection = signals::signal<void()>::connection;
+
+    signals::signal<void()> sig;
+    auto got1 = std::make_shared<uint32_t>(0);
+    connection conn1_old;
+    std::unique_ptr<connection> conn1_new;
+
+    conn1_old = sig.connect([&, got1]
+    {
+        ++*got1;
+        if (*got1 == 1)
+        {
+            auto& ref_copy = conn1_new;
+            ref_copy = std::make_unique<connection>(std::move(conn1_old));
+        }
+        ++*got1;
+    });
+
+    sig();
+    EXPECT_EQ(2u, *got1);
+
+    sig();
+    EXPECT_EQ(4u, *got1);
+}
+
+TEST(signal_testing, move_assign_in_emit_shared_capture)
+{
+    using connection = signals::signal<void()>::connection;
+
+    signals::signal<void()> sig;
+    auto got1 = std::make_shared<uint32_t>(0);
+    connection conn1_old;
+    connection conn1_new;
+
+    conn1_old = sig.connect([&, got1]
+    {
+        ++*got1;
+        if (*got1 == 1)
+            conn1_new = std::move(conn1_old);
+        ++*got1;
+    });
+
+    sig();
+    EXPECT_EQ(2u, *got1);
+
+    sig();
+    EXPECT_EQ(4u, *got1);
 
+    conn1_old = connection();
     sig();
-    EXPECT_EQ(2, got1);
+    EXPECT_EQ(6u, *got1);
+
+    conn1_new.disconnect();
+    EXPECT_EQ(1, got1.use_count());
+}
+
+TEST(signal_testing, move_in_emit_then_move_again)
+{
+    using connection = signals::signal<void(int)>::connection;
+
+    signals::signal<void(int)> sig;
+    auto got = std::make_shared<std::vector<int>>();
+    auto conn_old = std::make_unique<connection>();
+    connection conn_new;
+    connection conn_newer;
+
+    *conn_old = sig.connect([&, got](int depth)
+    {
+        got->push_back(depth);
+        if (depth == 2)
+            conn_new = std::move(*conn_old);
+        else if (depth == 1)
+            conn_newer = std::move(conn_new);
+        if (depth > 0)
+            sig(depth - 1);
+        got->push_back(depth);
+    });
+
+    sig(2);
+    EXPECT_EQ((std::vector<int>{2, 1, 0, 0, 1, 2}), *got);
+
+    conn_old.reset();
+    EXPECT_EQ(2, got.use_count());
+    sig(0);
+    EXPECT_EQ((std::vector<int>{2, 1, 0, 0, 1, 2, 0, 0}), *got);
+
+    conn_newer.disconnect();
+    EXPECT_EQ(1, got.use_count());
 }
 
 TEST(signal_testing, move_in_emit_02)
@@ -271,7 +487,2087 @@ TEST(signal_testing, move_in_emit_02)
     }));
     
     sig();
-    EXPECT_EQ(1, got1);
+    EXPECT_EQ(1u, got1);
+}
+
+TEST(signal_testing, move_only_slot)
+{
+    signals::signal<void(int)> sig;
+    auto value = std::make_unique<int>(0);
+    int* raw = value.get();
+    auto conn = sig.connect([value = std::move(value)](int x) { *value += x; });
+
+    sig(5);
+    sig(6);
+
+    EXPECT_EQ(11, *raw);
+}
+
+TEST(signal_testing, large_slot)
+{
+    signals::signal<void()> sig;
+    std::array<uint64_t, 16> payload{};
+    payload[15] = 42;
+    uint64_t got = 0;
+    auto conn1 = sig.connect([payload, &got] { got += payload[15]; });
+    auto conn2 = std::move(conn1);
+
+    sig();
+
+    EXPECT_EQ(42u, got);
+}
+
+TEST(signal_testing, slot_buffer_option)
+{
+    using small_signal = signals::signal<void(), signals::slot_buffer<8>>;
+    using large_signal = signals::signal<void(), signals::slot_buffer<128>>;
+    static_assert(sizeof(small_signal::connection) < sizeof(large_signal::connection));
+
+    large_signal sig;
+    std::array<uint64_t, 8> payload{1, 2, 3, 4, 5, 6, 7, 8};
+    uint64_t got = 0;
+    auto slot = [payload, &got] { got += payload[7]; };
+    static_assert(large_signal::slot_t::stored_inline<decltype(slot)>);
+    auto conn = sig.connect(std::move(slot));
+
+    sig();
+
+    EXPECT_EQ(8u, got);
+}
+
+TEST(signal_testing, small_function_destroys_target)
+{
+    auto counter = std::make_shared<int>(0);
+    {
+        signals::small_function<void()> fn([counter] {});
+        EXPECT_EQ(2, counter.use_count());
+        signals::small_function<void()> moved = std::move(fn);
+        EXPECT_FALSE(fn);
+        EXPECT_TRUE(moved);
+        EXPECT_EQ(2, counter.use_count());
+    }
+    EXPECT_EQ(1, counter.use_count());
+}
+
+TEST(signal_testing, emit_batch)
+{
+    signals::signal<void(int, char)> sig;
+    std::vector<std::pair<int, char>> got1;
+    auto conn1 = sig.connect([&](int a, char b) { got1.emplace_back(a, b); });
+    std::vector<std::pair<int, char>> got2;
+    auto conn2 = sig.connect([&](int a, char b) { got2.emplace_back(a, b); });
+
+    std::vector<std::tuple<int, char>> payloads{{1, 'a'}, {2, 'b'}, {3, 'c'}};
+    sig.emit_batch(payloads);
+
+    std::vector<std::pair<int, char>> expected{{1, 'a'}, {2, 'b'}, {3, 'c'}};
+    EXPECT_EQ(expected, got1);
+    EXPECT_EQ(expected, got2);
+}
+
+TEST(signal_testing, emit_batch_slot_major)
+{
+    signals::signal<void(int)> sig;
+    std::vector<int> order;
+    auto conn1 = sig.connect([&](int x) { order.push_back(x); });
+    auto conn2 = sig.connect([&](int x) { order.push_back(x * 10); });
+
+    sig.emit_batch(std::array<std::tuple<int>, 2>{{{1}, {2}}});
+
+    EXPECT_EQ((std::vector<int>{10, 20, 1, 2}), order);
+}
+
+TEST(signal_testing, disconnect_in_emit_batch)
+{
+    using connection = signals::signal<void(int)>::connection;
+    signals::signal<void(int)> sig;
+    uint32_t got1 = 0;
+    connection conn1 = sig.connect([&](int) { ++got1; });
+    uint32_t got2 = 0;
+    std::unique_ptr<connection> conn2;
+    conn2 = std::make_unique<connection>(sig.connect([&](int x)
+    {
+        ++got2;
+        if (x == 2)
+            conn2.reset();
+    }));
+
+    std::vector<std::tuple<int>> payloads{{1}, {2}, {3}, {4}};
+    sig.emit_batch(payloads);
+
+    EXPECT_EQ(2u, got2);
+    EXPECT_EQ(4u, got1);
+}
+
+TEST(signal_testing, destroy_signal_in_emit_batch)
+{
+    auto sig = std::make_unique<signals::signal<void(int)>>();
+    uint32_t got1 = 0;
+    auto conn1 = sig->connect([&](int) { ++got1; });
+    uint32_t got2 = 0;
+    auto conn2 = sig->connect([&](int)
+    {
+        if (++got2 == 2)
+            sig.reset();
+    });
+
+    std::vector<std::tuple<int>> payloads{{1}, {2}, {3}};
+    sig->emit_batch(payloads);
+
+    EXPECT_EQ(2u, got2);
+    EXPECT_EQ(0u, got1);
+}
+
+namespace
+{
+struct copy_counter
+{
+    explicit copy_counter(uint32_t& copies)
+        : copies(&copies)
+    {}
+
+    copy_counter(copy_counter const& other)
+        : copies(other.copies)
+    {
+        ++*copies;
+    }
+
+    copy_counter(copy_counter&& other) noexcept = default;
+
+    uint32_t* copies;
+};
+}
+
+TEST(signal_testing, no_argument_copies_in_emit)
+{
+    signals::signal<void(copy_counter)> sig;
+    uint32_t got = 0;
+    auto conn1 = sig.connect([&](copy_counter const&) { ++got; });
+    auto conn2 = sig.connect([&](copy_counter const&) { ++got; });
+    auto conn3 = sig.connect([&](copy_counter const&) { ++got; });
+
+    uint32_t copies = 0;
+    sig(copy_counter(copies));
+
+    EXPECT_EQ(3u, got);
+    EXPECT_EQ(0u, copies);
+}
+
+TEST(signal_testing, rvalue_argument_moved_to_last_slot)
+{
+    signals::signal<void(copy_counter&&)> sig;
+    uint32_t got = 0;
+    auto conn1 = sig.connect([&](copy_counter&& c) { copy_counter taken(std::move(c)); ++got; });
+    auto conn2 = sig.connect([&](copy_counter const&) { ++got; });
+    auto conn3 = sig.connect([&](copy_counter&& c) { copy_counter stolen(std::move(c)); ++got; });
+
+    uint32_t copies = 0;
+    sig(copy_counter(copies));
+
+    EXPECT_EQ(3u, got);
+    EXPECT_EQ(1u, copies);
+}
+
+TEST(signal_testing, rvalue_argument_shared_with_non_last_slots)
+{
+    signals::signal<void(std::string&&)> sig;
+    std::string last;
+    auto conn1 = sig.connect([&](std::string&& s) { last = std::move(s); });
+    std::string stolen;
+    auto conn2 = sig.connect([&](std::string&& s) { stolen = std::move(s); });
+    std::string seen;
+    auto conn3 = sig.connect([&](std::string const& s) { seen = s; });
+
+    sig(std::string(100, 'x'));
+
+    EXPECT_EQ(std::string(100, 'x'), seen);
+    EXPECT_EQ(std::string(100, 'x'), stolen);
+    EXPECT_EQ(std::string(100, 'x'), last);
+}
+
+TEST(signal_testing, combiner_last)
+{
+    signals::signal<int(int)> sig;
+    EXPECT_EQ(0, sig(1));
+
+    auto conn1 = sig.connect([](int x) { return x + 1; });
+    auto conn2 = sig.connect([](int x) { return x + 2; });
+
+    EXPECT_EQ(1, sig(0));
+}
+
+TEST(signal_testing, combiner_optional_first_invokes_one_slot)
+{
+    signals::signal<int(), signals::combiners::optional_first<int>> sig;
+    EXPECT_EQ(std::nullopt, sig());
+
+    uint32_t got1 = 0;
+    auto conn1 = sig.connect([&] { ++got1; return 1; });
+    uint32_t got2 = 0;
+    auto conn2 = sig.connect([&] { ++got2; return 2; });
+
+    EXPECT_EQ(2, sig());
+    EXPECT_EQ(0u, got1);
+    EXPECT_EQ(1u, got2);
+}
+
+TEST(signal_testing, combiner_sum_and_max)
+{
+    signals::signal<int(int), signals::combiners::sum<int>> sum;
+    signals::signal<int(int), signals::combiners::max<int>> max;
+    std::vector<decltype(sum)::connection> sum_conns;
+    std::vector<decltype(max)::connection> max_conns;
+    for (int i = 1; i <= 4; ++i)
+    {
+        sum_conns.push_back(sum.connect([i](int x) { return i * x; }));
+        max_conns.push_back(max.connect([i](int x) { return i * x; }));
+    }
+
+    EXPECT_EQ(20, sum(2));
+    EXPECT_EQ(8, max(2));
+    EXPECT_EQ(-2, max(-2));
+}
+
+TEST(signal_testing, combiner_collect)
+{
+    signals::signal<int(), signals::combiners::collect<int, 2>> sig;
+    std::vector<decltype(sig)::connection> conns;
+    for (int i = 0; i < 5; ++i)
+        conns.push_back(sig.connect([i] { return i; }));
+
+    auto result = sig();
+
+    EXPECT_EQ((std::vector<int>{4, 3, 2, 1, 0}), std::vector<int>(result.begin(), result.end()));
+    EXPECT_FALSE(result.is_inline());
+}
+
+TEST(signal_testing, small_vector_emplace_own_element)
+{
+    signals::small_vector<std::string, 2> v;
+    v.emplace_back(100, 'a');
+    v.emplace_back(100, 'b');
+
+    v.emplace_back(v[0]);
+    v.push_back(v[1]);
+
+    EXPECT_FALSE(v.is_inline());
+    EXPECT_EQ(4u, v.size());
+    EXPECT_EQ(std::string(100, 'a'), v[2]);
+    EXPECT_EQ(std::string(100, 'b'), v[3]);
+}
+
+namespace
+{
+/* Комбинатор, который двигает итератор постфиксным инкрементом. */
+struct postfix_sum
+{
+    template<typename InputIt>
+    int operator()(InputIt first, InputIt end) const
+    {
+        int total = 0;
+        while (first != end)
+            total += *first++;
+        return total;
+    }
+};
+
+struct not_a_combiner
+{
+};
+}
+
+TEST(signal_testing, combiner_postfix_increment)
+{
+    static_assert(!signals::detail::is_combiner_v<not_a_combiner, int>);
+    static_assert(!signals::detail::is_combiner_v<postfix_sum, void>);
+    static_assert(signals::detail::is_combiner_v<postfix_sum, int>);
+
+    signals::signal<int(), postfix_sum> sig;
+    auto conn1 = sig.connect([] { return 1; });
+    auto conn2 = sig.connect([] { return 20; });
+    auto conn3 = sig.connect([] { return 300; });
+
+    EXPECT_EQ(321, sig());
+}
+
+namespace
+{
+struct is_negative
+{
+    bool operator()(int x) const
+    {
+        return x < 0;
+    }
+};
+}
+
+TEST(signal_testing, combiner_short_circuit)
+{
+    signals::signal<int(), signals::combiners::short_circuit<int, is_negative>> sig;
+    uint32_t got1 = 0;
+    auto conn1 = sig.connect([&] { ++got1; return -1; });
+    auto conn2 = sig.connect([] { return -2; });
+    auto conn3 = sig.connect([] { return 3; });
+
+    EXPECT_EQ(-2, sig());
+    EXPECT_EQ(0u, got1);
+}
+
+TEST(signal_testing, stateful_combiner)
+{
+    auto pred = [](int x) { return x > 10; };
+    using combiner = signals::combiners::short_circuit<int, decltype(pred)>;
+    signals::signal<int(int), combiner> sig(combiner{pred});
+    auto conn1 = sig.connect([](int x) { return x * 10; });
+    auto conn2 = sig.connect([](int x) { return x; });
+
+    EXPECT_EQ(20, sig(2));
+    EXPECT_EQ(std::nullopt, sig(1));
+}
+
+TEST(signal_testing, disconnect_in_combined_emit)
+{
+    signals::signal<int(), signals::combiners::sum<int>> sig;
+    auto conn1 = sig.connect([] { return 1; });
+    std::unique_ptr<decltype(sig)::connection> conn2;
+    auto conn3 = sig.connect([&] { conn2.reset(); return 100; });
+    conn2 = std::make_unique<decltype(sig)::connection>(sig.connect([] { return 10; }));
+
+    EXPECT_EQ(111, sig());
+    EXPECT_EQ(101, sig());
+}
+
+TEST(signal_testing, destroy_signal_in_combined_emit)
+{
+    auto sig = std::make_unique<signals::signal<int(), signals::combiners::sum<int>>>();
+    auto conn1 = sig->connect([] { return 1; });
+    auto conn2 = sig->connect([&] { sig.reset(); return 10; });
+    auto conn3 = sig->connect([] { return 100; });
+
+    EXPECT_EQ(110, (*sig)());
+}
+
+TEST(signal_testing, priority_order)
+{
+    signals::signal<void()> sig;
+    std::vector<int> order;
+    auto record = [&](int id) { return [&order, id] { order.push_back(id); }; };
+
+    auto conn1 = sig.connect_back(record(1));
+    auto conn2 = sig.connect(0, record(2));
+    auto conn3 = sig.connect(10, record(3));
+    auto conn4 = sig.connect_front(record(4));
+    auto conn5 = sig.connect(0, record(5));
+    auto conn6 = sig.connect_back(record(6));
+    auto conn7 = sig.connect(-5, record(7));
+    auto conn8 = sig.connect(record(8));
+
+    sig();
+
+    EXPECT_EQ((std::vector<int>{8, 4, 3, 2, 5, 7, 1, 6}), order);
+}
+
+TEST(signal_testing, priority_connect_disconnect_in_emit)
+{
+    using connection = signals::signal<void()>::connection;
+    signals::signal<void()> sig;
+    std::vector<int> order;
+    connection late;
+    connection victim = sig.connect(1, [&] { order.push_back(3); });
+    connection first = sig.connect(2, [&]
+    {
+        order.push_back(1);
+        victim.disconnect();
+        late = sig.connect(1, [&] { order.push_back(2); });
+    });
+
+    sig();
+    EXPECT_EQ((std::vector<int>{1}), order);
+}
+
+TEST(signal_testing, connect_back_in_emit)
+{
+    using connection = signals::signal<void()>::connection;
+    signals::signal<void()> sig;
+    uint32_t got = 0;
+    std::vector<connection> conns;
+    conns.reserve(16);
+    conns.push_back(sig.connect_back([&]
+    {
+        if (conns.size() < 4)
+            conns.push_back(sig.connect_back([&] { ++got; }));
+    }));
+
+    sig();
+    EXPECT_EQ(0u, got);
+    EXPECT_EQ(2u, conns.size());
+
+    sig();
+    EXPECT_EQ(1u, got);
+}
+
+TEST(signal_testing, priority_connect_in_emit)
+{
+    using connection = signals::signal<void()>::connection;
+    signals::signal<void()> sig;
+    uint32_t calls = 0;
+    std::vector<connection> conns;
+    conns.reserve(16);
+    conns.push_back(sig.connect(2, [&]
+    {
+        ++calls;
+        conns.push_back(sig.connect(1, [&] { ++calls; }));
+        conns.push_back(sig.connect(2, [&] { ++calls; }));
+    }));
+
+    sig();
+    EXPECT_EQ(1u, calls);
+    EXPECT_EQ(3u, conns.size());
+
+    conns.resize(1);
+    sig();
+    EXPECT_EQ(2u, calls);
+}
+
+TEST(signal_testing, connect_in_nested_emit_visible_to_later_emissions)
+{
+    signals::signal<void(int)> sig;
+    std::vector<int> order;
+    signals::signal<void(int)>::connection late;
+    auto conn = sig.connect(1, [&](int depth)
+    {
+        order.push_back(depth);
+        if (depth == 1)
+        {
+            late = sig.connect_back([&](int d) { order.push_back(d * 10); });
+            sig(0);
+        }
+    });
+
+    sig(1);
+
+    EXPECT_EQ((std::vector<int>{1, 0, 0}), order);
+}
+
+TEST(signal_testing, empty_priority_groups_are_removed)
+{
+    signals::signal<void()> sig;
+    std::vector<int> order;
+    auto low = sig.connect(1, [&] { order.push_back(1); });
+    auto high = sig.connect(3, [&] { order.push_back(3); });
+
+    for (int i = 0; i < 100; ++i)
+        sig.connect(2, [] {}).disconnect();
+
+    std::size_t allocations = global_allocations;
+    sig.connect(2, [] {}).disconnect();
+    EXPECT_EQ(allocations + 1, global_allocations);
+
+    auto mid = sig.connect(2, [&]
+    {
+        order.push_back(2);
+        high.disconnect();
+    });
+    sig();
+    sig();
+    EXPECT_EQ((std::vector<int>{3, 2, 1, 2, 1}), order);
+
+    auto again = sig.connect(3, [&] { order.push_back(4); });
+    sig();
+    EXPECT_EQ((std::vector<int>{3, 2, 1, 2, 1, 4, 2, 1}), order);
+}
+
+TEST(signal_testing, priority_group_removed_in_emit)
+{
+    using connection = signals::signal<void()>::connection;
+    signals::signal<void()> sig;
+    std::vector<int> order;
+    connection conn2;
+    connection conn1 = sig.connect(2, [&]
+    {
+        order.push_back(1);
+        conn1.disconnect();
+        conn2.disconnect();
+    });
+    conn2 = sig.connect(2, [&] { order.push_back(2); });
+    connection conn3 = sig.connect(1, [&] { order.push_back(3); });
+
+    sig();
+    sig();
+
+    EXPECT_EQ((std::vector<int>{1, 3, 3}), order);
+}
+
+TEST(signal_testing, recursive_emit_across_groups)
+{
+    signals::signal<void(int)> sig;
+    std::vector<int> order;
+    auto conn1 = sig.connect(2, [&](int depth)
+    {
+        order.push_back(depth);
+        if (depth > 0)
+            sig(depth - 1);
+    });
+    auto conn2 = sig.connect(1, [&](int depth) { order.push_back(depth * 10); });
+    auto conn3 = sig.connect_back([&](int depth) { order.push_back(depth * 100); });
+
+    sig(1);
+
+    EXPECT_EQ((std::vector<int>{1, 0, 0, 0, 10, 100}), order);
+}
+
+TEST(signal_testing, destroy_signal_with_groups_in_emit)
+{
+    auto sig = std::make_unique<signals::signal<void()>>();
+    uint32_t got = 0;
+    auto conn1 = sig->connect(1, [&] { ++got; });
+    auto conn2 = sig->connect(2, [&] { sig.reset(); });
+    auto conn3 = sig->connect_back([&] { ++got; });
+
+    (*sig)();
+
+    EXPECT_EQ(0u, got);
+    conn1.disconnect();
+}
+
+namespace
+{
+struct counting_resource : std::pmr::memory_resource
+{
+    std::size_t allocations = 0;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+    {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+template<typename T>
+struct counting_allocator
+{
+    using value_type = T;
+
+    explicit counting_allocator(std::size_t& allocations) noexcept
+        : allocations(&allocations)
+    {}
+
+    template<typename U>
+    counting_allocator(counting_allocator<U> const& other) noexcept
+        : allocations(other.allocations)
+    {}
+
+    T* allocate(std::size_t n)
+    {
+        ++*allocations;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    friend bool operator==(counting_allocator const& a, counting_allocator const& b) noexcept
+    {
+        return a.allocations == b.allocations;
+    }
+
+    friend bool operator!=(counting_allocator const& a, counting_allocator const& b) noexcept
+    {
+        return !(a == b);
+    }
+
+    std::size_t* allocations;
+};
+}
+
+TEST(signal_testing, slot_allocator_option)
+{
+    using allocator = counting_allocator<std::byte>;
+    std::size_t allocations = 0;
+    signals::signal<void(), signals::slot_allocator<allocator>> sig{allocator(allocations)};
+
+    uint32_t got = 0;
+    std::array<char, 100> payload{};
+    auto conn1 = sig.connect([&got, payload] { got += 1 + payload[0]; });
+    EXPECT_EQ(1u, allocations);
+    auto conn2 = sig.connect([&got] { ++got; });
+    EXPECT_EQ(1u, allocations);
+    auto conn3 = sig.connect(5, [&got] { ++got; });
+    EXPECT_EQ(2u, allocations);
+
+    sig();
+    EXPECT_EQ(3u, got);
+}
+
+TEST(signal_testing, pmr_signal_churn_without_malloc)
+{
+    counting_resource upstream;
+    signals::slab_pool pool(&upstream);
+    signals::pmr::signal<void(int)> sig(&pool);
+
+    uint64_t sum = 0;
+    std::array<char, 100> payload{};
+    auto churn = [&]
+    {
+        for (int i = 0; i < 100; ++i)
+        {
+            auto conn1 = sig.connect(i % 4, [&sum, payload](int x) { sum += x + payload[0]; });
+            auto conn2 = sig.connect_back([&sum, payload](int x) { sum += x + payload[1]; });
+            sig(1);
+        }
+    };
+
+    churn();
+    std::size_t const warm_upstream = upstream.allocations;
+    std::size_t const warm_global = global_allocations;
+    churn();
+
+    EXPECT_EQ(400u, sum);
+    EXPECT_EQ(warm_upstream, upstream.allocations);
+    EXPECT_EQ(warm_global, global_allocations);
+}
+
+TEST(signal_testing, connection_group_disconnect_all)
+{
+    signals::signal<void(int)> sig1;
+    signals::contiguous_signal<void()> sig2;
+    signals::signal<int(), signals::slot_buffer<64>> sig3;
+    uint32_t got = 0;
+
+    signals::connection_group group;
+    for (int i = 0; i < 500; ++i)
+    {
+        group.add(sig1.connect([&](int x) { got += x; }));
+        group.add(sig2.connect([&] { ++got; }));
+        group += sig3.connect([&] { return ++got; });
+    }
+    EXPECT_EQ(1500u, group.size());
+
+    sig1(2);
+    sig2();
+    sig3();
+    EXPECT_EQ(2000u, got);
+
+    group.disconnect_all();
+    EXPECT_TRUE(group.empty());
+
+    sig1(2);
+    sig2();
+    sig3();
+    EXPECT_EQ(2000u, got);
+
+    group.add(sig1.connect([&](int x) { got += x; }));
+    sig1(1);
+    EXPECT_EQ(2001u, got);
+}
+
+TEST(signal_testing, connection_group_destructor)
+{
+    signals::signal<void()> sig;
+    uint32_t got = 0;
+    auto kept = sig.connect([&] { ++got; });
+    {
+        signals::scoped_connections group;
+        group.add(sig.connect([&] { ++got; }));
+        group.add(sig.connect([&] { ++got; }));
+
+        signals::scoped_connections moved(std::move(group));
+        sig();
+        EXPECT_EQ(3u, got);
+    }
+    sig();
+    EXPECT_EQ(4u, got);
+}
+
+TEST(signal_testing, connection_group_outlives_signal)
+{
+    signals::connection_group group;
+    auto payload = std::make_shared<int>(0);
+    std::weak_ptr<int> weak = payload;
+    {
+        signals::signal<void()> sig;
+        group.add(sig.connect([payload = std::move(payload)] {}));
+    }
+    EXPECT_TRUE(weak.expired());
+    group.disconnect_all();
+}
+
+TEST(signal_testing, deferred_teardown_keeps_slots)
+{
+    using signal = signals::signal<void(), signals::deferred_teardown>;
+    auto sig = std::make_unique<signal>();
+    auto payload = std::make_shared<int>(0);
+    std::weak_ptr<int> weak = payload;
+    uint32_t got = 0;
+    signal::connection conn1 = sig->connect([&got, payload = std::move(payload)] { ++got; });
+    signal::connection conn2 = sig->connect(1, [&got] { ++got; });
+    auto conn3 = sig->connect_back([&got] { ++got; });
+
+    (*sig)();
+    EXPECT_EQ(3u, got);
+
+    sig.reset();
+    EXPECT_FALSE(weak.expired());
+
+    signal::connection moved = std::move(conn1);
+    conn2 = std::move(moved);
+    EXPECT_FALSE(weak.expired());
+    conn2.disconnect();
+    EXPECT_TRUE(weak.expired());
+}
+
+TEST(signal_testing, deferred_teardown_destroy_in_emit)
+{
+    using signal = signals::signal<void(int), signals::deferred_teardown>;
+    auto sig = std::make_unique<signal>();
+    uint32_t got1 = 0;
+    signal::connection conn1 = sig->connect([&](int) { ++got1; });
+    signal::connection conn2 = sig->connect([&](int depth)
+    {
+        if (depth > 0)
+            (*sig)(depth - 1);
+        else
+            sig.reset();
+    });
+    signal::connection conn3 = sig->connect([&](int) { conn1.disconnect(); });
+
+    (*sig)(2);
+
+    EXPECT_EQ(0u, got1);
+    EXPECT_EQ(nullptr, sig);
+}
+
+TEST(signal_testing, instrumentation_counts)
+{
+    using signal = signals::signal<void(int), signals::stats_instrumentation>;
+    signal sig;
+    sig.set_name("counted");
+    signal::connection conn1 = sig.connect([](int) {});
+    signal::connection conn2 = sig.connect([&](int depth)
+    {
+        if (depth > 0)
+            sig(depth - 1);
+    });
+    signal::connection conn3 = sig.connect([&](int depth)
+    {
+        if (depth == 0)
+            conn1.disconnect();
+    });
+
+    sig(2);
+    sig(0);
+
+    signals::signal_stats const& stats = sig.stats();
+    EXPECT_EQ(4u, stats.emits);
+    EXPECT_EQ(3u, stats.connects);
+    EXPECT_EQ(1u, stats.disconnects);
+    EXPECT_EQ(1u, stats.disconnects_in_emit);
+    EXPECT_EQ(0u, stats.depth);
+    EXPECT_EQ(3u, stats.max_depth);
+    EXPECT_EQ(8u, stats.slot_latency.total());
+
+    std::vector<signals::signal_stats> snapshot = signals::stats_registry::instance().snapshot();
+    ASSERT_EQ(1u, snapshot.size());
+    EXPECT_EQ("counted", snapshot[0].name);
+    ASSERT_EQ(2u, snapshot[0].slots.size());
+    EXPECT_EQ(4u, snapshot[0].slots[0].calls);
+    EXPECT_EQ(4u, snapshot[0].slots[0].latency.total());
+    EXPECT_EQ(4u, snapshot[0].slots[1].calls);
+
+    conn2.disconnect();
+    EXPECT_EQ(2u, sig.stats().disconnects);
+    EXPECT_EQ(1u, sig.stats().disconnects_in_emit);
+}
+
+TEST(signal_testing, instrumentation_unregisters)
+{
+    using signal = signals::signal<void(), signals::stats_instrumentation, signals::deferred_teardown>;
+    auto sig = std::make_unique<signal>();
+    signal::connection conn = sig->connect([&] { sig.reset(); });
+    EXPECT_EQ(1u, signals::stats_registry::instance().size());
+
+    (*sig)();
+
+    EXPECT_EQ(nullptr, sig);
+    EXPECT_EQ(0u, signals::stats_registry::instance().size());
+    conn.disconnect();
+}
+
+TEST(signal_testing, instrumentation_disabled_adds_nothing)
+{
+    using disabled = signals::signal<void(int), signals::no_instrumentation>;
+    using enabled = signals::signal<void(int), signals::stats_instrumentation>;
+    /* Узел списка (три указателя), stamp, слот, счётчик connect_n и holders. */
+    static_assert(sizeof(void *) != 8 || sizeof(disabled::connection) == sizeof(disabled::slot_t) + 6 * sizeof(void *));
+    static_assert(sizeof(enabled::connection) >= sizeof(disabled::connection) + sizeof(signals::slot_stats));
+    static_assert(sizeof(enabled) >= sizeof(disabled) + sizeof(signals::signal_stats));
+
+    disabled sig;
+    auto conn = sig.connect([](int) {});
+    sig(1);
+    EXPECT_EQ(0u, signals::stats_registry::instance().size());
+}
+
+namespace
+{
+struct counter_object
+{
+    void add(int x)
+    {
+        total += x;
+    }
+
+    int get(int x) const
+    {
+        return total + x;
+    }
+
+    bool add_checked(int x)
+    {
+        total += x;
+        return total > 0;
+    }
+
+    int total = 0;
+};
+
+int free_total = 0;
+
+void free_add(int x)
+{
+    free_total += x;
+}
+
+void free_add_noexcept(int x) noexcept
+{
+    free_total += x;
+}
+
+int free_add_result(int x)
+{
+    free_total += x;
+    return free_total;
+}
+}
+
+TEST(signal_testing, delegate_slots)
+{
+    counter_object object;
+    free_total = 0;
+    signals::signal<void(int)> sig;
+
+    std::size_t allocations = global_allocations;
+    auto conn1 = sig.connect<&counter_object::add>(&object);
+    auto conn2 = sig.connect<&free_add>();
+    auto conn3 = sig.connect(&free_add);
+    auto conn4 = sig.connect_back(signals::delegate<&counter_object::add>(&object));
+    sig(2);
+    EXPECT_EQ(allocations, global_allocations);
+
+    EXPECT_EQ(4, object.total);
+    EXPECT_EQ(4, free_total);
+
+    conn1.disconnect();
+    sig(1);
+    EXPECT_EQ(5, object.total);
+    EXPECT_EQ(6, free_total);
+}
+
+TEST(signal_testing, delegate_const_method)
+{
+    counter_object const object{10};
+    signals::signal<int(int)> sig;
+    auto conn = sig.connect<&counter_object::get>(&object);
+
+    EXPECT_EQ(13, sig(3));
+}
+
+TEST(signal_testing, void_signal_discards_slot_results)
+{
+    counter_object object;
+    free_total = 0;
+    signals::signal<void(int)> sig;
+    int got = 0;
+    auto conn1 = sig.connect([&](int x) { return got += x; });
+    auto conn2 = sig.connect(&free_add_result);
+    auto conn3 = sig.connect<&counter_object::add_checked>(&object);
+
+    signals::signal<void(std::string &&)> strings;
+    std::string last;
+    auto conn4 = strings.connect([&](std::string &&s) { return last = std::move(s); });
+    auto conn5 = strings.connect([](std::string const &s) { return s.size(); });
+
+    sig(2);
+    strings(std::string("value"));
+
+    EXPECT_EQ(2, got);
+    EXPECT_EQ(2, free_total);
+    EXPECT_EQ(2, object.total);
+    EXPECT_EQ("value", last);
+}
+
+TEST(signal_testing, slot_count)
+{
+    signals::signal<void()> sig;
+    EXPECT_FALSE(sig.has_slots());
+    EXPECT_EQ(0u, sig.slot_count());
+
+    auto conn1 = sig.connect([] {});
+    auto conn2 = sig.connect(1, [] {});
+    auto conn3 = sig.connect_back([&] { conn1.disconnect(); });
+    EXPECT_TRUE(sig.has_slots());
+    EXPECT_EQ(3u, sig.slot_count());
+
+    auto moved = std::move(conn2);
+    EXPECT_EQ(3u, sig.slot_count());
+
+    sig();
+    EXPECT_EQ(2u, sig.slot_count());
+
+    moved.disconnect();
+    conn3.disconnect();
+    EXPECT_FALSE(sig.has_slots());
+}
+
+TEST(signal_testing, slot_count_deferred_teardown)
+{
+    using signal = signals::signal<void(), signals::deferred_teardown>;
+    auto sig = std::make_unique<signal>();
+    signal::connection conn1 = sig->connect([] {});
+    signal::connection conn2 = sig->connect([] {});
+    EXPECT_EQ(2u, sig->slot_count());
+
+    conn1.disconnect();
+    EXPECT_EQ(1u, sig->slot_count());
+
+    sig.reset();
+    conn2.disconnect();
+}
+
+TEST(signal_testing, emit_lazy)
+{
+    signals::signal<void(std::string const&)> sig;
+    uint32_t built = 0;
+    auto factory = [&]
+    {
+        ++built;
+        return std::string("payload");
+    };
+
+    sig.emit_lazy(factory);
+    EXPECT_EQ(0u, built);
+
+    std::string got;
+    auto conn = sig.connect([&](std::string const& s) { got = s; });
+    sig.emit_lazy(factory);
+    EXPECT_EQ(1u, built);
+    EXPECT_EQ("payload", got);
+
+    conn.disconnect();
+    sig.emit_lazy(factory);
+    EXPECT_EQ(1u, built);
+}
+
+TEST(signal_testing, emit_lazy_tuple_and_result)
+{
+    signals::signal<int(int, int), signals::combiners::sum<int>> sig;
+    uint32_t built = 0;
+    auto factory = [&]
+    {
+        ++built;
+        return std::make_tuple(2, 3);
+    };
+
+    EXPECT_EQ(0, sig.emit_lazy(factory));
+    EXPECT_EQ(0u, built);
+
+    auto conn1 = sig.connect([](int a, int b) { return a + b; });
+    auto conn2 = sig.connect([](int a, int b) { return a * b; });
+    EXPECT_EQ(11, sig.emit_lazy(factory));
+    EXPECT_EQ(1u, built);
+}
+
+TEST(signal_testing, collect_exceptions)
+{
+    struct test_exception : std::exception
+    {};
+
+    using signal = signals::signal<void(int), signals::collect_exceptions>;
+    signal sig;
+    uint32_t got = 0;
+    auto conn1 = sig.connect([&](int) { ++got; });
+    auto conn2 = sig.connect([](int) { throw test_exception(); });
+    auto conn3 = sig.connect([&](int) { ++got; });
+    auto conn4 = sig.connect([](int x) { throw x; });
+
+    try
+    {
+        sig(7);
+        FAIL();
+    }
+    catch (signals::emission_error const& e)
+    {
+        ASSERT_EQ(2u, e.errors.size());
+        EXPECT_THROW(std::rethrow_exception(e.errors[0]), int);
+        EXPECT_THROW(std::rethrow_exception(e.errors[1]), test_exception);
+    }
+    EXPECT_EQ(2u, got);
+
+    conn2.disconnect();
+    conn4.disconnect();
+    sig(7);
+    EXPECT_EQ(4u, got);
+}
+
+TEST(signal_testing, collect_exceptions_destroy_in_emit)
+{
+    using signal = signals::signal<void(), signals::collect_exceptions>;
+    auto sig = std::make_unique<signal>();
+    uint32_t got = 0;
+    signal::connection conn1 = sig->connect([&] { ++got; });
+    signal::connection conn2 = sig->connect([&]
+    {
+        sig.reset();
+        throw 1;
+    });
+
+    EXPECT_THROW((*sig)(), signals::emission_error);
+    EXPECT_EQ(nullptr, sig);
+    EXPECT_EQ(0u, got);
+}
+
+TEST(signal_testing, noexcept_slots)
+{
+    using signal = signals::signal<void(int), signals::noexcept_slots>;
+    signal sig;
+    static_assert(noexcept(sig(1)));
+    static_assert(!noexcept(std::declval<signals::signal<void(int)>&>()(1)));
+
+    uint32_t got = 0;
+    auto conn1 = sig.connect([&](int x) noexcept { got += x; });
+    auto conn2 = sig.connect(signals::delegate<&free_add_noexcept>());
+    sig(2);
+
+    EXPECT_EQ(2u, got);
+}
+
+namespace
+{
+struct tracked_listener : signals::trackable
+{
+    explicit tracked_listener(int& total)
+        : total(&total)
+    {}
+
+    void on_value(int x)
+    {
+        *total += x;
+    }
+
+    int* total;
+};
+}
+
+TEST(signal_testing, tracked_slots_disconnect_with_object)
+{
+    signals::signal<void(int)> sig;
+    int total = 0;
+    {
+        tracked_listener listener(total);
+        signals::connect_tracked<&tracked_listener::on_value>(sig, listener);
+        signals::connect_tracked(sig, listener, [&listener](int x) { listener.on_value(x * 10); });
+        EXPECT_EQ(2u, sig.slot_count());
+
+        sig(1);
+        EXPECT_EQ(11, total);
+    }
+    EXPECT_FALSE(sig.has_slots());
+
+    sig(1);
+    EXPECT_EQ(11, total);
+}
+
+TEST(signal_testing, tracked_object_destroyed_in_emit)
+{
+    signals::signal<void(int)> sig;
+    int total = 0;
+    auto listener = std::make_unique<tracked_listener>(total);
+    signals::connect_tracked<&tracked_listener::on_value>(sig, *listener);
+    signals::connect_tracked<&tracked_listener::on_value>(sig, *listener);
+    auto conn = sig.connect([&](int) { listener.reset(); });
+
+    sig(1);
+
+    EXPECT_EQ(0, total);
+    EXPECT_EQ(nullptr, listener);
+    EXPECT_EQ(1u, sig.slot_count());
+}
+
+TEST(signal_testing, tracked_object_outlives_signal)
+{
+    int total = 0;
+    tracked_listener listener(total);
+    {
+        signals::signal<void(int)> sig;
+        signals::connect_tracked<&tracked_listener::on_value>(sig, listener);
+        sig(3);
+    }
+    listener.disconnect_tracked();
+    EXPECT_EQ(3, total);
+}
+
+TEST(signal_testing, connect_once)
+{
+    signals::signal<void()> sig;
+    uint32_t got1 = 0;
+    auto conn1 = sig.connect_once([&] { ++got1; });
+    uint32_t got2 = 0;
+    auto conn2 = sig.connect([&] { ++got2; });
+    EXPECT_EQ(2u, sig.slot_count());
+
+    sig();
+
+    EXPECT_EQ(1u, got1);
+    EXPECT_EQ(1u, got2);
+    EXPECT_EQ(1u, sig.slot_count());
+
+    sig();
+
+    EXPECT_EQ(1u, got1);
+    EXPECT_EQ(2u, got2);
+    conn1.disconnect();
+    EXPECT_EQ(1u, sig.slot_count());
+}
+
+TEST(signal_testing, connect_n)
+{
+    signals::signal<void(int)> sig;
+    int total = 0;
+    auto conn = sig.connect_n(3, [&](int x) { total += x; });
+    auto none = sig.connect_n(0, [&](int x) { total += 100 * x; });
+    EXPECT_EQ(1u, sig.slot_count());
+
+    for (int i = 1; i <= 5; ++i)
+    {
+        sig(i);
+    }
+
+    EXPECT_EQ(6, total);
+    EXPECT_FALSE(sig.has_slots());
+}
+
+TEST(signal_testing, connect_once_recursive_emit)
+{
+    signals::signal<void()> sig;
+    uint32_t got = 0;
+    auto conn = sig.connect_once([&] {
+        ++got;
+        sig();
+    });
+
+    sig();
+
+    EXPECT_EQ(1u, got);
+}
+
+TEST(signal_testing, connect_once_destroy_connection_in_emit)
+{
+    using connection = signals::signal<void()>::connection;
+    signals::signal<void()> sig;
+    uint32_t got1 = 0;
+    auto conn1 = std::make_unique<connection>(sig.connect([&] { ++got1; }));
+    uint32_t got2 = 0;
+    auto payload = std::make_shared<int>(1);
+    std::unique_ptr<connection> conn2;
+    conn2.reset(new connection(sig.connect_once([&, payload] {
+        conn2.reset();
+        got2 += *payload;
+    })));
+    uint32_t got3 = 0;
+    auto conn3 = std::make_unique<connection>(sig.connect([&] { ++got3; }));
+
+    sig();
+    sig();
+
+    EXPECT_EQ(2u, got1);
+    EXPECT_EQ(1u, got2);
+    EXPECT_EQ(2u, got3);
+    EXPECT_EQ(1, payload.use_count());
+}
+
+TEST(signal_testing, connect_n_emit_batch)
+{
+    signals::signal<void(int)> sig;
+    std::vector<int> got;
+    auto conn = sig.connect_n(2, [&](int x) { got.push_back(x); });
+    std::vector<std::tuple<int>> payloads{{1}, {2}, {3}};
+
+    sig.emit_batch(payloads);
+    sig(4);
+
+    EXPECT_EQ((std::vector<int>{1, 2}), got);
+}
+
+TEST(signal_testing, connect_n_moved_connection)
+{
+    signals::signal<void()> sig;
+    uint32_t got = 0;
+    signals::signal<void()>::connection conn;
+    conn = sig.connect_n(2, [&] { ++got; });
+    auto moved = std::move(conn);
+
+    sig();
+    sig();
+    sig();
+
+    EXPECT_EQ(2u, got);
+}
+
+TEST(signal_testing, block_connection)
+{
+    signals::signal<void()> sig;
+    std::vector<int> got;
+    auto conn1 = sig.connect_back([&] { got.push_back(1); });
+    auto conn2 = sig.connect_back([&] { got.push_back(2); });
+    auto conn3 = sig.connect_back([&] { got.push_back(3); });
+
+    conn2.block();
+    EXPECT_TRUE(conn2.blocked());
+    sig();
+    conn2.unblock();
+    EXPECT_FALSE(conn2.blocked());
+    sig();
+
+    EXPECT_EQ((std::vector<int>{1, 3, 1, 2, 3}), got);
+    EXPECT_EQ(3u, sig.slot_count());
+}
+
+TEST(signal_testing, block_in_emit)
+{
+    signals::signal<void()> sig;
+    std::vector<int> got;
+    signals::signal<void()>::connection conn2;
+    auto conn1 = sig.connect_back([&] {
+        got.push_back(1);
+        conn2.block();
+    });
+    conn2 = sig.connect_back([&] {
+        got.push_back(2);
+    });
+
+    sig();
+    conn2.unblock();
+    conn1.block();
+    sig();
+
+    EXPECT_EQ((std::vector<int>{1, 2}), got);
+}
+
+TEST(signal_testing, blocked_last_slot_does_not_take_rvalue)
+{
+    signals::signal<void(std::string &&)> sig;
+    std::string first;
+    std::string last;
+    auto conn1 = sig.connect_back([&](std::string &&s) { first = std::move(s); });
+    auto conn2 = sig.connect_back([&](std::string &&s) { last = std::move(s); });
+
+    conn2.block();
+    sig(std::string("payload"));
+
+    EXPECT_EQ("payload", first);
+    EXPECT_EQ("", last);
+}
+
+TEST(signal_testing, shared_block)
+{
+    using signal = signals::signal<void()>;
+    signal sig;
+    uint32_t got = 0;
+    auto conn = sig.connect([&] { ++got; });
+    {
+        signal::shared_block block(conn);
+        sig();
+        {
+            signal::shared_block copy = block;
+            sig();
+        }
+        EXPECT_TRUE(conn.blocked());
+        sig();
+    }
+    EXPECT_FALSE(conn.blocked());
+    sig();
+
+    EXPECT_EQ(1u, got);
+}
+
+TEST(signal_testing, shared_block_follows_moved_connection)
+{
+    using signal = signals::signal<void()>;
+    signal sig;
+    uint32_t got = 0;
+    signal::connection conn = sig.connect([&] { ++got; });
+    std::vector<signal::connection> moved;
+    {
+        signal::shared_block block(conn);
+        signal::shared_block copy = block;
+        moved.push_back(std::move(conn));
+        moved.reserve(16);
+        EXPECT_TRUE(moved[0].blocked());
+        sig();
+    }
+    EXPECT_FALSE(moved[0].blocked());
+    sig();
+    EXPECT_EQ(1u, got);
+
+    auto other = sig.connect([&] { got += 10; });
+    {
+        signal::shared_block block(moved[0]);
+        moved[0] = std::move(other);
+        EXPECT_FALSE(moved[0].blocked());
+        sig();
+    }
+    EXPECT_EQ(11u, got);
+
+    {
+        auto temporary = std::make_unique<signal::connection>(sig.connect([] {}));
+        signal::shared_block block(*temporary);
+        temporary.reset();
+    }
+    sig();
+    EXPECT_EQ(21u, got);
+}
+
+TEST(signal_testing, block_all)
+{
+    signals::signal<int(), signals::combiners::sum<int>> sig;
+    uint32_t got = 0;
+    auto conn = sig.connect([&] {
+        ++got;
+        return 5;
+    });
+
+    sig.block_all();
+    EXPECT_TRUE(sig.blocked());
+    EXPECT_FALSE(sig.active());
+    EXPECT_EQ(1u, sig.slot_count());
+    EXPECT_EQ(0, sig());
+    EXPECT_EQ(0u, got);
+
+    sig.unblock_all();
+    EXPECT_TRUE(sig.active());
+    EXPECT_EQ(5, sig());
+    EXPECT_EQ(1u, got);
+}
+
+TEST(signal_testing, block_all_survives_connect_and_disconnect)
+{
+    signals::signal<void()> sig;
+    uint32_t got = 0;
+    sig.block_all();
+    EXPECT_FALSE(sig.active());
+
+    auto first = sig.connect([&] { ++got; });
+    auto second = sig.connect([&] { ++got; });
+    first.disconnect();
+    EXPECT_TRUE(sig.blocked());
+    EXPECT_EQ(1u, sig.slot_count());
+    sig();
+    EXPECT_EQ(0u, got);
+
+    sig.unblock_all();
+    sig();
+    EXPECT_EQ(1u, got);
+
+    second.disconnect();
+    EXPECT_FALSE(sig.blocked());
+    EXPECT_FALSE(sig.active());
+}
+
+TEST(signal_testing, block_all_void)
+{
+    signals::signal<void(int)> sig;
+    int total = 0;
+    auto conn = sig.connect([&](int x) { total += x; });
+    std::vector<std::tuple<int>> payloads{{1}, {2}};
+    bool made = false;
+
+    sig.block_all();
+    sig(10);
+    sig.emit_batch(payloads);
+    sig.emit_lazy([&] {
+        made = true;
+        return 100;
+    });
+    sig.unblock_all();
+    sig(1);
+
+    EXPECT_EQ(1, total);
+    EXPECT_FALSE(made);
+    EXPECT_EQ(1u, sig.slot_count());
+}
+
+namespace
+{
+/* Корутина, которая запускается сразу и сама разрушается в конце. */
+struct detached
+{
+    struct promise_type
+    {
+        detached get_return_object()
+        {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void()
+        {}
+
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+};
+
+detached collect_next(signals::signal<void(int)>& sig, std::vector<int>& got, int count)
+{
+    for (int i = 0; i < count; ++i)
+        got.push_back(co_await sig.next());
+}
+
+detached await_pair_then_empty(signals::signal<void(int, std::string const&)>& pair, signals::signal<void()>& empty,
+                               std::tuple<int, std::string>& got, bool& done)
+{
+    got = co_await pair.next();
+    co_await empty.next();
+    done = true;
+}
+
+detached await_on_loop(signals::signal<void(int)>& sig, signals::event_loop& loop, int& got)
+{
+    got = co_await sig.next(loop);
+}
+
+template<typename Stream>
+detached concat_stream(Stream& stream, std::string& got, int count)
+{
+    for (int i = 0; i < count; ++i)
+        got += co_await stream.next();
+}
+}
+
+TEST(signal_testing, await_next)
+{
+    signals::signal<void(int)> sig;
+    std::vector<int> got;
+    got.reserve(3);
+    uint32_t plain = 0;
+    auto conn = sig.connect([&](int) { ++plain; });
+    collect_next(sig, got, 3);
+    EXPECT_EQ(2u, sig.slot_count());
+
+    std::size_t allocations = global_allocations;
+    sig(1);
+    sig(2);
+    EXPECT_EQ(allocations, global_allocations);
+    sig(3);
+    sig(4);
+
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), got);
+    EXPECT_EQ(4u, plain);
+    EXPECT_EQ(1u, sig.slot_count());
+}
+
+TEST(signal_testing, await_next_arguments)
+{
+    signals::signal<void(int, std::string const&)> pair;
+    signals::signal<void()> empty;
+    std::tuple<int, std::string> got;
+    bool done = false;
+    await_pair_then_empty(pair, empty, got, done);
+
+    pair(5, "five");
+    EXPECT_FALSE(done);
+    empty();
+
+    EXPECT_TRUE(done);
+    EXPECT_EQ(std::make_tuple(5, std::string("five")), got);
+}
+
+TEST(signal_testing, await_next_on_executor)
+{
+    signals::signal<void(int)> sig;
+    signals::event_loop loop;
+    int got = 0;
+    await_on_loop(sig, loop, got);
+
+    sig(7);
+    EXPECT_EQ(0, got);
+    EXPECT_FALSE(sig.has_slots());
+
+    EXPECT_EQ(1u, loop.poll());
+    EXPECT_EQ(7, got);
+}
+
+TEST(signal_testing, await_emission_stream)
+{
+    signals::signal<void(std::string)> sig;
+    auto stream = sig.emissions();
+    sig("a");
+    sig("b");
+    EXPECT_EQ(2u, stream.pending_count());
+
+    std::string got;
+    concat_stream(stream, got, 3);
+    EXPECT_EQ("ab", got);
+
+    sig("c");
+    EXPECT_EQ("abc", got);
+    EXPECT_EQ(0u, stream.pending_count());
+}
+
+TEST(contiguous_signal_testing, trivial)
+{
+    signals::contiguous_signal<void(int)> sig;
+    std::vector<int> order;
+    auto conn1 = sig.connect([&](int x) { order.push_back(x); });
+    auto conn2 = sig.connect([&](int x) { order.push_back(x * 10); });
+
+    sig(1);
+
+    EXPECT_EQ((std::vector<int>{1, 10}), order);
+
+    conn1.disconnect();
+    sig(2);
+
+    EXPECT_EQ((std::vector<int>{1, 10, 20}), order);
+}
+
+TEST(contiguous_signal_testing, disconnect_in_emit)
+{
+    using connection = signals::contiguous_signal<void()>::connection;
+    signals::contiguous_signal<void()> sig;
+    uint32_t got1 = 0;
+    connection conn1 = sig.connect([&] { ++got1; });
+    uint32_t got2 = 0;
+    std::unique_ptr<connection> conn2;
+    conn2.reset(new connection(sig.connect([&] { ++got2; conn2.reset(); })));
+    uint32_t got3 = 0;
+    connection conn3 = sig.connect([&] { ++got3; });
+
+    sig();
+
+    EXPECT_EQ(1u, got1);
+    EXPECT_EQ(1u, got2);
+    EXPECT_EQ(1u, got3);
+
+    sig();
+
+    EXPECT_EQ(2u, got1);
+    EXPECT_EQ(1u, got2);
+    EXPECT_EQ(2u, got3);
+}
+
+TEST(contiguous_signal_testing, disconnect_next_in_emit)
+{
+    using connection = signals::contiguous_signal<void()>::connection;
+    signals::contiguous_signal<void()> sig;
+    uint32_t got2 = 0;
+    connection conn2;
+    connection conn1 = sig.connect([&] { conn2.disconnect(); });
+    conn2 = sig.connect([&] { ++got2; });
+
+    sig();
+
+    EXPECT_EQ(0u, got2);
+}
+
+TEST(contiguous_signal_testing, connect_in_emit)
+{
+    using connection = signals::contiguous_signal<void()>::connection;
+    signals::contiguous_signal<void()> sig;
+    uint32_t got = 0;
+    std::vector<connection> conns;
+    conns.reserve(16);
+    conns.push_back(sig.connect([&]
+    {
+        if (conns.size() < 4)
+            conns.push_back(sig.connect([&] { ++got; }));
+    }));
+
+    sig();
+    EXPECT_EQ(0u, got);
+
+    sig();
+    EXPECT_EQ(1u, got);
+}
+
+TEST(contiguous_signal_testing, many_connects_in_emit)
+{
+    using connection = signals::contiguous_signal<void()>::connection;
+    signals::contiguous_signal<void()> sig;
+    uint32_t got = 0;
+    std::vector<connection> conns;
+    conns.reserve(128);
+    conns.push_back(sig.connect([&]
+    {
+        for (int i = 0; i != 100 && conns.size() < 101; ++i)
+            conns.push_back(sig.connect([&] { ++got; }));
+    }));
+
+    sig();
+    EXPECT_EQ(0u, got);
+
+    sig();
+    EXPECT_EQ(100u, got);
+
+    for (std::size_t i = 1; i < conns.size(); i += 2)
+        conns[i].disconnect();
+    sig();
+    EXPECT_EQ(150u, got);
+}
+
+TEST(contiguous_signal_testing, move_and_compact)
+{
+    using connection = signals::contiguous_signal<void()>::connection;
+    signals::contiguous_signal<void()> sig;
+    uint32_t got = 0;
+    std::vector<connection> conns;
+    for (int i = 0; i < 10; ++i)
+        conns.push_back(sig.connect([&] { ++got; }));
+
+    for (int i = 0; i < 10; i += 2)
+        conns[i].disconnect();
+    conns.erase(conns.begin(), conns.begin() + 3);
+
+    sig();
+
+    EXPECT_EQ(4u, got);
+}
+
+TEST(contiguous_signal_testing, destroy_signal_in_emit)
+{
+    using connection = signals::contiguous_signal<void()>::connection;
+
+    auto sig = std::make_unique<signals::contiguous_signal<void()>>();
+    uint32_t got1 = 0;
+    connection conn1(sig->connect([&] { ++got1; }));
+    connection conn2(sig->connect([&] { sig.reset(); }));
+    uint32_t got3 = 0;
+    connection conn3(sig->connect([&] { ++got3; }));
+
+    (*sig)();
+
+    EXPECT_EQ(1u, got1);
+    EXPECT_EQ(0u, got3);
+}
+
+namespace
+{
+std::vector<int> static_calls;
+
+void static_first(int x)
+{
+    static_calls.push_back(x);
+}
+
+void static_second(int const& x)
+{
+    static_calls.push_back(x * 10);
+}
+
+std::string static_shared;
+std::string static_taken;
+
+void static_share(std::string const& s)
+{
+    static_shared = s;
+}
+
+void static_take(std::string&& s)
+{
+    static_taken = std::move(s);
+}
+
+template<typename Signal>
+void fire(Signal const& sig, int x)
+{
+    sig(x);
+}
+}
+
+TEST(static_signal_testing, handlers_in_order)
+{
+    static_calls.clear();
+    signals::static_signal<void(int), &static_first, &static_second, &static_first> sig;
+    static_assert(decltype(sig)::size == 3);
+
+    sig(2);
+
+    EXPECT_EQ((std::vector<int>{2, 20, 2}), static_calls);
+}
+
+TEST(static_signal_testing, no_handlers)
+{
+    signals::static_signal<void(int)> sig;
+    sig(1);
+}
+
+TEST(static_signal_testing, rvalue_argument_moved_to_last)
+{
+    signals::static_signal<void(std::string&&), &static_share, &static_take> sig;
+    std::string value(100, 'x');
+
+    sig(std::move(value));
+
+    EXPECT_EQ(std::string(100, 'x'), static_shared);
+    EXPECT_EQ(std::string(100, 'x'), static_taken);
+}
+
+TEST(static_signal_testing, interchangeable_with_signal)
+{
+    static_calls.clear();
+    signals::signal<void(int)> dynamic;
+    auto conn = dynamic.connect(&static_first);
+    signals::static_signal<void(int), &static_first> fixed;
+
+    fire(dynamic, 1);
+    fire(fixed, 2);
+
+    EXPECT_EQ((std::vector<int>{1, 2}), static_calls);
+}
+
+TEST(hybrid_signal_testing, static_then_dynamic)
+{
+    static_calls.clear();
+    using signal = signals::hybrid_signal<void(int), &static_first, &static_second>;
+    signal sig;
+
+    sig(1);
+    EXPECT_EQ((std::vector<int>{1, 10}), static_calls);
+
+    signal::connection conn = sig.connect([](int x) { static_calls.push_back(-x); });
+    signal::connection moved = std::move(conn);
+    sig(2);
+    EXPECT_EQ((std::vector<int>{1, 10, 2, 20, -2}), static_calls);
+
+    moved.disconnect();
+    fire(sig, 3);
+    EXPECT_EQ((std::vector<int>{1, 10, 2, 20, -2, 3, 30}), static_calls);
+}
+
+TEST(hybrid_signal_testing, rvalue_argument_moved_to_last_dynamic_slot)
+{
+    static_shared.clear();
+    signals::hybrid_signal<void(std::string&&), &static_share> sig;
+    std::string taken;
+    auto conn = sig.connect([&](std::string&& s) { taken = std::move(s); });
+    std::string value(100, 'x');
+
+    sig(std::move(value));
+
+    EXPECT_EQ(std::string(100, 'x'), static_shared);
+    EXPECT_EQ(std::string(100, 'x'), taken);
+}
+
+TEST(hybrid_signal_testing, rvalue_argument_moved_to_last_handler)
+{
+    static_shared.clear();
+    static_taken.clear();
+    signals::hybrid_signal<void(std::string&&), &static_share, &static_take> sig;
+    EXPECT_EQ(2u, sig.slot_count());
+    std::string value(100, 'x');
+
+    sig(std::move(value));
+
+    EXPECT_EQ(std::string(100, 'x'), static_shared);
+    EXPECT_EQ(std::string(100, 'x'), static_taken);
+}
+
+TEST(hybrid_signal_testing, emit_lazy)
+{
+    static_calls.clear();
+    signals::hybrid_signal<void(int)> empty;
+    uint32_t built = 0;
+    empty.emit_lazy([&] { return ++built; });
+    EXPECT_EQ(0u, built);
+
+    signals::hybrid_signal<void(int), &static_first> sig;
+    sig.emit_lazy([&] { return ++built; });
+    EXPECT_EQ(1u, built);
+    EXPECT_EQ((std::vector<int>{1}), static_calls);
+}
+
+TEST(hybrid_signal_testing, every_emission_calls_handlers)
+{
+    using signal = signals::hybrid_signal<void(int), &static_first>;
+    static_assert(!std::is_convertible_v<signal &, signals::signal<void(int)> &>);
+    static_calls.clear();
+    signal sig;
+    std::vector<int> dynamic;
+    auto conn = sig.connect([&](int x) { dynamic.push_back(x); });
+    std::vector<std::tuple<int>> payloads{{3}, {4}};
+
+    sig(1);
+    sig.emit_lazy([] { return 2; });
+    sig.emit_batch(payloads);
+    fire(sig, 5);
+
+    EXPECT_EQ((std::vector<int>{1, 2, 3, 4, 5}), static_calls);
+    EXPECT_EQ((std::vector<int>{1, 2, 3, 4, 5}), dynamic);
+
+    sig.block_all();
+    sig.emit_batch(payloads);
+    sig(6);
+    EXPECT_EQ((std::vector<int>{1, 2, 3, 4, 5, 3, 4, 6}), static_calls);
+    EXPECT_EQ(5u, dynamic.size());
+
+    sig.unblock_all();
+    sig(7);
+    EXPECT_EQ(7, dynamic.back());
+}
+
+namespace
+{
+struct list_node : intrusive::list_element<>
+{
+    explicit list_node(int value = 0) : value(value) {}
+
+    int value;
+};
+
+std::vector<int> list_values(intrusive::list<list_node> const &list)
+{
+    std::vector<int> values;
+    for (list_node const &n : list)
+    {
+        values.push_back(n.value);
+    }
+    return values;
+}
+}
+
+TEST(intrusive_list_testing, splice_whole_list)
+{
+    list_node a(1), b(2), c(3), d(4);
+    intrusive::list<list_node> to;
+    intrusive::list<list_node> from;
+    to.push_back(a);
+    to.push_back(d);
+    from.push_back(b);
+    from.push_back(c);
+
+    to.splice(to.as_iterator(d), from);
+    EXPECT_TRUE(from.empty());
+    EXPECT_EQ((std::vector<int>{1, 2, 3, 4}), list_values(to));
+
+    to.splice(to.end(), from);
+    EXPECT_EQ((std::vector<int>{1, 2, 3, 4}), list_values(to));
+}
+
+TEST(intrusive_list_testing, move)
+{
+    list_node a(1), b(2);
+    intrusive::list<list_node> empty;
+    intrusive::list<list_node> moved_empty(std::move(empty));
+    EXPECT_TRUE(moved_empty.empty());
+
+    intrusive::list<list_node> from;
+    from.push_back(a);
+    from.push_back(b);
+    intrusive::list<list_node> to(std::move(from));
+    EXPECT_TRUE(from.empty());
+    EXPECT_EQ((std::vector<int>{1, 2}), list_values(to));
+
+    list_node c(3);
+    from.push_back(c);
+    from = std::move(to);
+    EXPECT_FALSE(c.is_linked());
+    EXPECT_EQ((std::vector<int>{1, 2}), list_values(from));
+}
+
+TEST(intrusive_list_testing, erase_range)
+{
+    std::vector<list_node> nodes(5);
+    intrusive::list<list_node> list;
+    for (int i = 0; i < 5; ++i)
+    {
+        nodes[i].value = i;
+        list.push_back(nodes[i]);
+    }
+
+    auto it = list.erase(list.as_iterator(nodes[1]), list.as_iterator(nodes[4]));
+    EXPECT_EQ(&nodes[4], &*it);
+    EXPECT_EQ((std::vector<int>{0, 4}), list_values(list));
+    EXPECT_FALSE(nodes[2].is_linked());
+
+    it = list.erase(list.begin(), list.begin());
+    EXPECT_EQ(list.begin(), it);
+    it = list.erase(list.begin(), list.end());
+    EXPECT_EQ(list.end(), it);
+    EXPECT_TRUE(list.empty());
+    EXPECT_FALSE(nodes[0].is_linked());
+}
+
+TEST(intrusive_list_testing, clear_unsafe_detach)
+{
+    auto a = std::make_unique<list_node>(1);
+    auto b = std::make_unique<list_node>(2);
+    auto c = std::make_unique<list_node>(3);
+    intrusive::list<list_node> list;
+    list.push_back(*a);
+    list.push_back(*b);
+    list.push_back(*c);
+
+    list.clear_unsafe_detach();
+    EXPECT_TRUE(list.empty());
+    EXPECT_TRUE(b->is_linked());
+
+    b.reset();
+    EXPECT_EQ(c.get(), a->next);
+    a.reset();
+    EXPECT_FALSE(c->is_linked());
+
+    list.push_back(*c);
+    EXPECT_EQ((std::vector<int>{3}), list_values(list));
+}
+
+TEST(intrusive_list_testing, clear_unsafe_detach_single)
+{
+    list_node a(1);
+    intrusive::list<list_node> list;
+    list.push_back(a);
+
+    list.clear_unsafe_detach();
+    EXPECT_TRUE(list.empty());
+    EXPECT_FALSE(a.is_linked());
+    EXPECT_EQ(&a, a.next);
+    EXPECT_EQ(&a, a.prev);
+
+    a.unlink();
+    list.push_back(a);
+    EXPECT_EQ((std::vector<int>{1}), list_values(list));
+    list.clear();
+}
+
+namespace
+{
+struct sized_node : intrusive::list_element<intrusive::default_tag, intrusive::tracked_size>
+{
+};
+
+using sized_list = intrusive::list<sized_node, intrusive::default_tag, intrusive::tracked_size>;
+}
+
+TEST(intrusive_list_testing, untracked_size_keeps_layout)
+{
+    static_assert(sizeof(intrusive::list_element<>) == 2 * sizeof(void *));
+    static_assert(sizeof(intrusive::list<list_node>) == 2 * sizeof(void *));
+    static_assert(sizeof(sized_node) == 3 * sizeof(void *));
+}
+
+TEST(intrusive_list_testing, tracked_size)
+{
+    std::vector<sized_node> nodes(6);
+    sized_list list;
+    EXPECT_EQ(0u, list.size());
+
+    list.push_back(nodes[0]);
+    list.push_front(nodes[1]);
+    list.insert(list.end(), nodes[2]);
+    list.insert(list.begin(), nodes[3]);
+    EXPECT_EQ(4u, list.size());
+
+    list.pop_back();
+    list.erase(list.begin());
+    EXPECT_EQ(2u, list.size());
+
+    nodes[1].unlink();
+    EXPECT_EQ(1u, list.size());
+    nodes[1].unlink();
+    EXPECT_EQ(1u, list.size());
+
+    list.push_back(nodes[4]);
+    list.push_back(nodes[5]);
+    list.erase(list.as_iterator(nodes[0]), list.as_iterator(nodes[5]));
+    EXPECT_EQ(1u, list.size());
+
+    list.clear();
+    EXPECT_EQ(0u, list.size());
+    EXPECT_TRUE(list.empty());
+}
+
+TEST(intrusive_list_testing, tracked_size_splice_and_move)
+{
+    std::vector<sized_node> nodes(5);
+    sized_list a;
+    sized_list b;
+    for (int i = 0; i < 3; ++i)
+    {
+        a.push_back(nodes[i]);
+    }
+    b.push_back(nodes[3]);
+    b.push_back(nodes[4]);
+
+    a.splice(a.end(), b, b.begin(), b.as_iterator(nodes[4]));
+    EXPECT_EQ(4u, a.size());
+    EXPECT_EQ(1u, b.size());
+
+    a.splice(a.begin(), a, a.as_iterator(nodes[2]), a.end());
+    EXPECT_EQ(4u, a.size());
+
+    b.splice(b.begin(), a);
+    EXPECT_EQ(0u, a.size());
+    EXPECT_EQ(5u, b.size());
+
+    nodes[3].unlink();
+    EXPECT_EQ(4u, b.size());
+
+    sized_list c(std::move(b));
+    EXPECT_EQ(0u, b.size());
+    EXPECT_EQ(4u, c.size());
+    nodes[0].unlink();
+    EXPECT_EQ(3u, c.size());
+
+    a.push_back(nodes[3]);
+    a = std::move(c);
+    EXPECT_EQ(3u, a.size());
+    EXPECT_FALSE(nodes[3].is_linked());
+}
+
+TEST(intrusive_list_testing, tracked_size_element_destroyed)
+{
+    sized_list list;
+    auto node = std::make_unique<sized_node>();
+    sized_node other;
+    list.push_back(*node);
+    list.push_back(other);
+
+    node.reset();
+
+    EXPECT_EQ(1u, list.size());
 }
 
 int main(int argc, char** argv)
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+
+namespace signals {
+/*
+Пул блоков фиксированных размеров (от 16 до 512 байт) для слотов
+и служебных структур сигналов. Блоки каждого размера нарезаются
+из слабов, полученных у upstream, и после освобождения попадают
+в список свободных блоков своего размера, так что в устоявшемся
+режиме подключения и отключения не обращаются к upstream.
+Память возвращается upstream только при разрушении пула.
+
+Пул не потокобезопасен: его заводят на сигнал или на поток.
+Более крупные или сильнее выровненные блоки запрашиваются
+напрямую у upstream.
+*/
+struct slab_pool : std::pmr::memory_resource {
+  static constexpr std::size_t min_block = 16;
+  static constexpr std::size_t max_block = 512;
+  static constexpr std::size_t slab_size = 4096;
+
+  explicit slab_pool(std::pmr::memory_resource *upstream = std::pmr::get_default_resource()) noexcept
+      : upstream(upstream) {}
+
+  slab_pool(slab_pool const &) = delete;
+  slab_pool &operator=(slab_pool const &) = delete;
+
+  ~slab_pool() override {
+    while (slabs != nullptr) {
+      slab *s = slabs;
+      slabs = s->next;
+      upstream->deallocate(s, slab_size, alignof(std::max_align_t));
+    }
+  }
+
+ private:
+  static constexpr std::size_t classes = 6;
+
+  struct free_block {
+    free_block *next;
+  };
+
+  struct slab {
+    slab *next;
+  };
+
+  static std::size_t class_of(std::size_t bytes) noexcept {
+    std::size_t index = 0;
+    for (std::size_t size = min_block; size < bytes; size *= 2) {
+      ++index;
+    }
+    return index;
+  }
+
+  void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+    if (bytes > max_block || alignment > alignof(std::max_align_t)) {
+      return upstream->allocate(bytes, alignment);
+    }
+
+    std::size_t index = class_of(bytes);
+    if (free[index] == nullptr) {
+      refill(index);
+    }
+    free_block *block = free[index];
+    free[index] = block->next;
+    return block;
+  }
+
+  void do_deallocate(void *p, std::size_t bytes, std::size_t alignment) override {
+    if (bytes > max_block || alignment > alignof(std::max_align_t)) {
+      upstream->deallocate(p, bytes, alignment);
+      return;
+    }
+
+    std::size_t index = class_of(bytes);
+    free[index] = new(p) free_block{free[index]};
+  }
+
+  bool do_is_equal(std::pmr::memory_resource const &other) const noexcept override {
+    return this == &other;
+  }
+
+  /* Нарезает новый слаб на блоки размера класса index. */
+  void refill(std::size_t index) {
+    auto *memory = static_cast<unsigned char *>(upstream->allocate(slab_size, alignof(std::max_align_t)));
+    slabs = new(memory) slab{slabs};
+
+    std::size_t const block = min_block << index;
+    for (std::size_t offset = alignof(std::max_align_t) > block ? alignof(std::max_align_t) : block;
+         offset + block <= slab_size; offset += block) {
+      free[index] = new(memory + offset) free_block{free[index]};
+    }
+  }
+
+  std::pmr::memory_resource *upstream;
+  slab *slabs = nullptr;
+  free_block *free[classes] = {};
+};
+}
@@ -0,0 +1,329 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace signals {
+namespace detail {
+/*
+Тип, в котором аргумент передаётся через small_function и signal.
+Аргументы, объявленные по значению, передаются как const lvalue,
+чтобы один объект можно было отдать нескольким слотам без копий.
+Ссылочные аргументы передаются как есть.
+*/
+template<typename T>
+struct call_arg {
+  using type = T const &;
+};
+
+template<typename T>
+struct call_arg<T &> {
+  using type = T &;
+};
+
+template<typename T>
+struct call_arg<T &&> {
+  using type = T &&;
+};
+
+template<typename T>
+using call_arg_t = typename call_arg<T>::type;
+
+/* То же, но rvalue-ссылки заменены на const lvalue: аргумент ещё понадобится. */
+template<typename T>
+struct shared_arg : call_arg<T> {};
+
+template<typename T>
+struct shared_arg<T &&> {
+  using type = T const &;
+};
+
+template<typename T>
+using shared_arg_t = typename shared_arg<T>::type;
+
+/* Копия аргумента, объявленного rvalue-ссылкой, для слота, который принимает только rvalue. */
+template<typename T, typename U>
+decltype(auto) share_or_copy(U &arg) {
+  if constexpr (std::is_rvalue_reference_v<T>) {
+    return std::remove_cv_t<std::remove_reference_t<T>>(arg);
+  } else {
+    return static_cast<call_arg_t<T>>(arg);
+  }
+}
+}
+
+/*
+Делегаты: функция или метод, известные на этапе компиляции, и указатель
+на объект. В small_function делегат занимает не больше одного указателя
+во встроенном буфере, а вызов - это один косвенный вызов invoker,
+внутри которого функция вызывается напрямую.
+*/
+template<auto Method, typename T>
+struct bound_member {
+  template<typename... As>
+  auto operator()(As &&... as) const noexcept(noexcept(std::invoke(Method, std::declval<T *>(), std::forward<As>(as)...)))
+      -> decltype(std::invoke(Method, std::declval<T *>(), std::forward<As>(as)...)) {
+    return std::invoke(Method, object, std::forward<As>(as)...);
+  }
+
+  T *object;
+};
+
+template<auto Function>
+struct bound_function {
+  template<typename... As>
+  auto operator()(As &&... as) const noexcept(noexcept(std::invoke(Function, std::forward<As>(as)...)))
+      -> decltype(std::invoke(Function, std::forward<As>(as)...)) {
+    return std::invoke(Function, std::forward<As>(as)...);
+  }
+};
+
+template<auto Method, typename T>
+bound_member<Method, T> delegate(T *object) noexcept {
+  return {object};
+}
+
+template<auto Function>
+bound_function<Function> delegate() noexcept {
+  return {};
+}
+
+template<typename Signature, std::size_t BufferSize = 32, typename Alloc = std::allocator<std::byte>>
+struct small_function;
+
+/*
+Move-only аналог std::function. Функциональный объект хранится
+во встроенном буфере размера BufferSize, поэтому для типичных лямбд
+не нужно аллоцировать память. Объекты, которые не помещаются в буфер,
+размещаются в куче через аллокатор Alloc. Копия аллокатора хранится
+в том же блоке, что и объект, поэтому размер small_function от Alloc
+не зависит.
+
+Аргументы, объявленные по значению, принимаются по const-ссылке
+(см. detail::call_arg_t), поэтому вызов ничего не копирует.
+Если в сигнатуре есть rvalue-ссылки, то operator() отдаёт их
+объекту как rvalue, а call_shared - как const lvalue (или копию,
+если объект принимает только rvalue): так вызывают все слоты,
+кроме последнего.
+*/
+template<typename R, typename... Args, std::size_t BufferSize, typename Alloc>
+struct small_function<R(Args...), BufferSize, Alloc> {
+  static_assert(BufferSize >= sizeof(void *), "buffer must fit at least a pointer");
+
+  static constexpr bool movable_args = (std::is_rvalue_reference_v<Args> || ...);
+
+  template<typename F>
+  static constexpr bool stored_inline = sizeof(F) <= BufferSize
+      && alignof(F) <= alignof(std::max_align_t)
+      && std::is_nothrow_move_constructible_v<F>;
+
+  /* Объект можно вызвать через call_shared: напрямую или с копиями rvalue-аргументов. */
+  template<typename F>
+  static constexpr bool shareable = !movable_args
+      || std::is_invocable_r_v<R, F &, detail::shared_arg_t<Args>...>
+      || (std::is_copy_constructible_v<std::remove_cv_t<std::remove_reference_t<Args>>> && ...);
+
+  small_function() noexcept = default;
+
+  small_function(std::nullptr_t) noexcept {}
+
+  template<typename F>
+  static constexpr bool accepts = !std::is_same_v<std::decay_t<F>, small_function>
+      && std::is_invocable_r_v<R, std::decay_t<F> &, detail::call_arg_t<Args>...>
+      && shareable<std::decay_t<F>>;
+
+  template<typename F, typename = std::enable_if_t<accepts<F>>>
+  small_function(F &&f) : small_function(std::allocator_arg, Alloc(), std::forward<F>(f)) {}
+
+  template<typename F, typename = std::enable_if_t<accepts<F>>>
+  small_function(std::allocator_arg_t, Alloc const &alloc, F &&f) {
+    using functor = std::decay_t<F>;
+
+    if constexpr (std::is_pointer_v<functor> || std::is_member_pointer_v<functor>) {
+      if (f == nullptr) {
+        return;
+      }
+    }
+
+    if constexpr (stored_inline<functor>) {
+      new(storage) functor(std::forward<F>(f));
+      if constexpr (!std::is_trivially_copyable_v<functor>) {
+        manager = &manage_inline<functor>;
+      }
+      invoker = &invoke<functor, false>;
+    } else {
+      using block_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<heap_block<functor>>;
+      block_alloc ba(alloc);
+      heap_block<functor> *block = std::allocator_traits<block_alloc>::allocate(ba, 1);
+      try {
+        new(block) heap_block<functor>{alloc, functor(std::forward<F>(f))};
+      } catch (...) {
+        std::allocator_traits<block_alloc>::deallocate(ba, block, 1);
+        throw;
+      }
+      *reinterpret_cast<heap_block<functor> **>(storage) = block;
+      manager = &manage_heap<functor>;
+      invoker = &invoke<functor, true>;
+    }
+  }
+
+  small_function(small_function const &) = delete;
+  small_function &operator=(small_function const &) = delete;
+
+  small_function(small_function &&other) noexcept {
+    move_from(other);
+  }
+
+  small_function &operator=(small_function &&other) noexcept {
+    if (this != &other) {
+      reset();
+      move_from(other);
+    }
+    return *this;
+  }
+
+  small_function &operator=(std::nullptr_t) noexcept {
+    reset();
+    return *this;
+  }
+
+  ~small_function() {
+    reset();
+  }
+
+  explicit operator bool() const noexcept {
+    return invoker != nullptr;
+  }
+
+  R operator()(detail::call_arg_t<Args>... args) const {
+    if constexpr (movable_args) {
+      return invoker(storage, false, std::forward<detail::call_arg_t<Args>>(args)...);
+    } else {
+      return invoker(storage, args...);
+    }
+  }
+
+  R call_shared(detail::call_arg_t<Args>... args) const {
+    if constexpr (movable_args) {
+      return invoker(storage, true, std::forward<detail::call_arg_t<Args>>(args)...);
+    } else {
+      return invoker(storage, args...);
+    }
+  }
+
+  /* Как std::function::target: хранимый объект, если он типа F, иначе nullptr. */
+  template<typename F>
+  F *target() const noexcept {
+    if (invoker != static_cast<invoker_t>(&invoke<F, !stored_inline<F>>)) {
+      return nullptr;
+    }
+    return &object<F, !stored_inline<F>>(storage);
+  }
+
+  void reset() noexcept {
+    if (manager != nullptr) {
+      manager(storage, nullptr);
+    }
+    invoker = nullptr;
+    manager = nullptr;
+  }
+
+ private:
+  /* Для сигнатур с rvalue-ссылками invoker дополнительно получает флаг shared. */
+  using invoker_t = std::conditional_t<movable_args,
+                                       R (*)(void *, bool, detail::call_arg_t<Args>...),
+                                       R (*)(void *, detail::call_arg_t<Args>...)>;
+  /*
+  manager(src, dst) перемещает объект из src в dst и разрушает src,
+  manager(src, nullptr) просто разрушает объект. Для тривиально
+  копируемых объектов manager не нужен, они перемещаются memcpy.
+  */
+  using manager_t = void (*)(void *, void *) noexcept;
+
+  template<typename F>
+  struct heap_block {
+    Alloc alloc;
+    F object;
+  };
+
+  template<typename F, bool Heap>
+  static F &object(void *storage) noexcept {
+    if constexpr (Heap) {
+      return (*static_cast<heap_block<F> **>(storage))->object;
+    } else {
+      return *static_cast<F *>(storage);
+    }
+  }
+
+  /* Как std::function: при R = void результат объекта отбрасывается. */
+  template<typename F, typename... As>
+  static R invoke_r(F &f, As &&... as) {
+    if constexpr (std::is_void_v<R>) {
+      std::invoke(f, std::forward<As>(as)...);
+    } else {
+      return std::invoke(f, std::forward<As>(as)...);
+    }
+  }
+
+  template<typename F, bool Heap>
+  static R invoke(void *storage, detail::call_arg_t<Args>... args) {
+    return invoke_r(object<F, Heap>(storage), std::forward<detail::call_arg_t<Args>>(args)...);
+  }
+
+  template<typename F, bool Heap>
+  static R invoke(void *storage, bool shared, detail::call_arg_t<Args>... args) {
+    F &f = object<F, Heap>(storage);
+    if (!shared) {
+      return invoke_r(f, std::forward<detail::call_arg_t<Args>>(args)...);
+    }
+    if constexpr (std::is_invocable_r_v<R, F &, detail::shared_arg_t<Args>...>) {
+      return invoke_r(f, static_cast<detail::shared_arg_t<Args>>(args)...);
+    } else {
+      return invoke_r(f, detail::share_or_copy<Args>(args)...);
+    }
+  }
+
+  template<typename F>
+  static void manage_inline(void *src, void *dst) noexcept {
+    F *object = static_cast<F *>(src);
+    if (dst != nullptr) {
+      new(dst) F(std::move(*object));
+    }
+    object->~F();
+  }
+
+  template<typename F>
+  static void manage_heap(void *src, void *dst) noexcept {
+    if (dst != nullptr) {
+      std::memcpy(dst, src, sizeof(heap_block<F> *));
+    } else {
+      using block_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<heap_block<F>>;
+      heap_block<F> *block = *static_cast<heap_block<F> **>(src);
+      block_alloc ba(block->alloc);
+      block->~heap_block();
+      std::allocator_traits<block_alloc>::deallocate(ba, block, 1);
+    }
+  }
+
+  void move_from(small_function &other) noexcept {
+    if (other.manager != nullptr) {
+      other.manager(other.storage, storage);
+    } else if (other.invoker != nullptr) {
+      std::memcpy(storage, other.storage, BufferSize);
+    }
+    invoker = other.invoker;
+    manager = other.manager;
+    other.invoker = nullptr;
+    other.manager = nullptr;
+  }
+
+  invoker_t invoker = nullptr;
+  manager_t manager = nullptr;
+  alignas(std::max_align_t) mutable unsigned char storage[BufferSize];
+};
+}
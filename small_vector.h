@@ -0,0 +1,239 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace signals {
+/*
+Вектор, первые N элементов которого хранятся во встроенном буфере.
+Пока элементов не больше N, память не аллоцируется. Поддерживается
+только то, что нужно библиотеке: добавление в конец, доступ и обход.
+*/
+template<typename T, std::size_t N>
+struct small_vector {
+  static_assert(N > 0, "inline capacity must be positive");
+
+  using value_type = T;
+  using size_type = std::size_t;
+  using iterator = T *;
+  using const_iterator = T const *;
+
+  small_vector() noexcept = default;
+
+  small_vector(small_vector const &other) {
+    reserve(other.count);
+    try {
+      std::uninitialized_copy(other.begin(), other.end(), first);
+    } catch (...) {
+      release();
+      throw;
+    }
+    count = other.count;
+  }
+
+  small_vector(small_vector &&other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    steal(other);
+  }
+
+  small_vector &operator=(small_vector const &other) {
+    if (this != &other) {
+      small_vector copy(other);
+      clear();
+      release();
+      steal(copy);
+    }
+    return *this;
+  }
+
+  small_vector &operator=(small_vector &&other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    if (this != &other) {
+      clear();
+      release();
+      steal(other);
+    }
+    return *this;
+  }
+
+  ~small_vector() {
+    clear();
+    release();
+  }
+
+  template<typename... As>
+  T &emplace_back(As &&... args) {
+    if (count == cap) {
+      return grow_emplace_back(std::forward<As>(args)...);
+    }
+    T *slot = new(first + count) T(std::forward<As>(args)...);
+    ++count;
+    return *slot;
+  }
+
+  void push_back(T const &value) {
+    emplace_back(value);
+  }
+
+  void push_back(T &&value) {
+    emplace_back(std::move(value));
+  }
+
+  void reserve(size_type capacity) {
+    if (capacity <= cap) {
+      return;
+    }
+
+    T *fresh = std::allocator<T>().allocate(capacity);
+    try {
+      move_to(fresh, capacity);
+    } catch (...) {
+      std::allocator<T>().deallocate(fresh, capacity);
+      throw;
+    }
+  }
+
+  void clear() noexcept {
+    std::destroy(begin(), end());
+    count = 0;
+  }
+
+  bool is_inline() const noexcept {
+    return first == inline_data();
+  }
+
+  size_type size() const noexcept {
+    return count;
+  }
+
+  size_type capacity() const noexcept {
+    return cap;
+  }
+
+  bool empty() const noexcept {
+    return count == 0;
+  }
+
+  T *data() noexcept {
+    return first;
+  }
+
+  T const *data() const noexcept {
+    return first;
+  }
+
+  T &operator[](size_type i) noexcept {
+    return first[i];
+  }
+
+  T const &operator[](size_type i) const noexcept {
+    return first[i];
+  }
+
+  T &back() noexcept {
+    return first[count - 1];
+  }
+
+  T const &back() const noexcept {
+    return first[count - 1];
+  }
+
+  iterator begin() noexcept {
+    return first;
+  }
+
+  iterator end() noexcept {
+    return first + count;
+  }
+
+  const_iterator begin() const noexcept {
+    return first;
+  }
+
+  const_iterator end() const noexcept {
+    return first + count;
+  }
+
+  friend bool operator==(small_vector const &a, small_vector const &b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end());
+  }
+
+  friend bool operator!=(small_vector const &a, small_vector const &b) {
+    return !(a == b);
+  }
+
+ private:
+  T *inline_data() const noexcept {
+    return reinterpret_cast<T *>(const_cast<unsigned char *>(buffer));
+  }
+
+  /*
+  Как в std::vector: новый элемент строится в новом буфере до переноса
+  старых, потому что args могут ссылаться на элемент этого же вектора.
+  */
+  template<typename... As>
+  T &grow_emplace_back(As &&... args) {
+    size_type const capacity = cap * 2;
+    T *fresh = std::allocator<T>().allocate(capacity);
+    T *slot = nullptr;
+    try {
+      slot = new(fresh + count) T(std::forward<As>(args)...);
+      move_to(fresh, capacity);
+    } catch (...) {
+      if (slot != nullptr) {
+        slot->~T();
+      }
+      std::allocator<T>().deallocate(fresh, capacity);
+      throw;
+    }
+    ++count;
+    return *slot;
+  }
+
+  /* Переносит элементы в fresh и делает его буфером вектора. Если перенос бросил, вектор не меняется. */
+  void move_to(T *fresh, size_type capacity) {
+    size_type moved = 0;
+    try {
+      for (; moved < count; ++moved) {
+        new(fresh + moved) T(std::move_if_noexcept(first[moved]));
+      }
+    } catch (...) {
+      std::destroy(fresh, fresh + moved);
+      throw;
+    }
+    std::destroy(begin(), end());
+    release();
+    first = fresh;
+    cap = capacity;
+  }
+
+  /* Освобождает кучу, если элементы жили в ней. Элементы уже разрушены. */
+  void release() noexcept {
+    if (!is_inline()) {
+      std::allocator<T>().deallocate(first, cap);
+      first = inline_data();
+      cap = N;
+    }
+  }
+
+  /* Забирает элементы other, оставляя его пустым. *this пуст и без кучи. */
+  void steal(small_vector &other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    if (other.is_inline()) {
+      std::uninitialized_move(other.begin(), other.end(), first);
+      count = other.count;
+      other.clear();
+    } else {
+      first = std::exchange(other.first, other.inline_data());
+      cap = std::exchange(other.cap, N);
+      count = std::exchange(other.count, 0);
+    }
+  }
+
+  alignas(T) unsigned char buffer[N * sizeof(T)];
+  T *first = inline_data();
+  size_type count = 0;
+  size_type cap = N;
+};
+}
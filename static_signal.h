@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include "small_function.h"
+
+namespace signals {
+
+template<typename T, auto... Handlers>
+struct static_signal;
+
+/*
+Сигнал с набором обработчиков, известным на этапе компиляции:
+static_signal<void(int), &on_a, &on_b>. Обработчики - функции
+или другие значения, вызываемые через std::invoke. Эмиссия - это
+последовательность прямых вызовов в порядке перечисления, которую
+компилятор может встроить целиком; ни списка, ни косвенных вызовов.
+
+operator() принимает аргументы так же, как signal::operator(),
+поэтому код, параметризованный типом сигнала, работает с обоими.
+Аргументы, объявленные rvalue-ссылкой, все обработчики, кроме
+последнего, получают как const lvalue (или копию, если обработчик
+принимает только rvalue), а последний - как rvalue.
+*/
+template<typename... Args, auto... Handlers>
+struct static_signal<void(Args...), Handlers...> {
+  static_assert(((std::is_invocable_v<decltype(Handlers), detail::call_arg_t<Args>...>) && ...),
+                "every handler must accept the signal arguments");
+
+  static constexpr std::size_t size = sizeof...(Handlers);
+
+  void operator()(detail::call_arg_t<Args>... args) const {
+    emit<true>(std::index_sequence_for<decltype(Handlers)...>(), std::forward<detail::call_arg_t<Args>>(args)...);
+  }
+
+  /* Эмиссия, после которой аргументы ещё понадобятся: rvalue не отдаётся никому. */
+  void call_shared(detail::call_arg_t<Args>... args) const {
+    emit<false>(std::index_sequence_for<decltype(Handlers)...>(), std::forward<detail::call_arg_t<Args>>(args)...);
+  }
+
+ private:
+  template<bool MoveToLast, std::size_t... I>
+  static void emit(std::index_sequence<I...>, detail::call_arg_t<Args>... args) {
+    (call<Handlers, MoveToLast && I + 1 == size>(args...), ...);
+  }
+
+  template<auto Handler, bool Last>
+  static void call(detail::call_arg_t<Args> &... args) {
+    if constexpr (Last) {
+      std::invoke(Handler, std::forward<detail::call_arg_t<Args>>(args)...);
+    } else if constexpr (std::is_invocable_v<decltype(Handler), detail::shared_arg_t<Args>...>) {
+      std::invoke(Handler, static_cast<detail::shared_arg_t<Args>>(args)...);
+    } else {
+      std::invoke(Handler, detail::share_or_copy<Args>(args)...);
+    }
+  }
+};
+}
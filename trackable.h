@@ -0,0 +1,56 @@
+#pragma once
+
+#include <type_traits>
+#include <utility>
+#include "connection_group.h"
+#include "small_function.h"
+
+namespace signals {
+/*
+База для объектов, слоты которых должны отключаться вместе с ними.
+Подключения, сделанные через connect_tracked, принадлежат объекту
+и разрываются в деструкторе trackable, поэтому эмиссия не видит
+мёртвых объектов и не трогает никаких счётчиков ссылок.
+
+Деструктор trackable выполняется после деструктора наследника:
+если объект разрушается, пока один из его слотов может быть вызван
+(например, из другого слота), наследнику стоит сначала вызвать
+disconnect_tracked. Копия объекта подключений не наследует.
+*/
+struct trackable {
+  /* Разрывает все подключения, сделанные через connect_tracked. */
+  void disconnect_tracked() noexcept {
+    tracked.disconnect_all();
+  }
+
+ protected:
+  trackable() noexcept = default;
+
+  trackable(trackable const &) noexcept {}
+
+  trackable &operator=(trackable const &) noexcept {
+    return *this;
+  }
+
+  ~trackable() = default;
+
+ private:
+  template<typename Signal, typename T, typename F>
+  friend void connect_tracked(Signal &sig, T &object, F &&slot);
+
+  connection_group tracked;
+};
+
+/* Подключает slot к sig на время жизни object. */
+template<typename Signal, typename T, typename F>
+void connect_tracked(Signal &sig, T &object, F &&slot) {
+  static_assert(std::is_base_of_v<trackable, T>, "tracked objects must derive from signals::trackable");
+  static_cast<trackable &>(object).tracked.add(sig.connect(std::forward<F>(slot)));
+}
+
+/* Подключает метод Method объекта object на время жизни object. */
+template<auto Method, typename Signal, typename T>
+void connect_tracked(Signal &sig, T &object) {
+  connect_tracked(sig, object, delegate<Method>(&object));
+}
+}